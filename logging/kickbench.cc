@@ -0,0 +1,216 @@
+// kickbench.cc
+//
+// Replays the ball observations of a vision log through the tracker
+// with and without the multiple hypothesis bank and reports how
+// quickly each converges to the ball's new velocity after kicks, and
+// the CPU time spent tracking per frame.
+//
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "../reality/net_vision.h"
+#include "constants.h"
+#include "vtracker.h"
+#include "timer.h"
+#include "util.h"
+
+// Frames after a kick before the tracker is considered to have failed.
+#define MAX_CONVERGE_FRAMES 30
+
+/*********************** GLOBALS *****************************/
+
+vector<net_vframe> frames;
+
+VTracker trackers[2];
+const char *tracker_names[2] = { "single hypothesis", "multi hypothesis" };
+
+/*********************** CODE ********************************/
+
+static bool ball_seen(net_vframe &vf)
+{
+  return (vf.ball.vision.timestamp == vf.timestamp && vf.ball.vision.conf > 0);
+}
+
+static void observe(VTracker &tracker, net_vframe &vf)
+{
+  tracker.ball.observe(vf.ball.vision, vf.timestamp);
+
+  for(int t = 0; t < NUM_TEAMS; t++) {
+    for(int i = 0; i < MAX_TEAM_ROBOTS; i++) {
+      if (vf.config.teams[t].robots[i].id >= 0)
+	tracker.robots[t][i].observe(vf.robots[t][i].vision, vf.timestamp);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  char *input_fname = NULL;
+  FILE *logfile = NULL;
+  double kick_threshold = 1000.0;
+  double tolerance = 250.0;
+  int window = 3;
+
+  char c;
+
+  while((c = getopt(argc, argv, "f:k:e:w:h")) != EOF) {
+    switch (c) {
+    case 'f': input_fname = optarg; break;
+    case 'k': kick_threshold = atof(optarg); break;
+    case 'e': tolerance = atof(optarg); break;
+    case 'w': window = atoi(optarg); break;
+    case 'h':
+    default:
+      if (argc > 1)
+	fprintf(stderr, "%s: Unknown option -%c.", argv[0], c);
+      fprintf(stderr, "USAGE: kickbench -f <filename>\n");
+      fprintf(stderr, "\t-f <filename>\t input log file\n");
+      fprintf(stderr, "\t-k <mm/s>\t velocity change counted as a kick "
+	      "(default %.0f)\n", kick_threshold);
+      fprintf(stderr, "\t-e <mm/s>\t velocity error counted as converged "
+	      "(default %.0f)\n", tolerance);
+      fprintf(stderr, "\t-w <frames>\t half-width of the reference "
+	      "velocity window (default %d)\n", window);
+      exit(1);
+    }
+  }
+
+  if (!input_fname) {
+    fprintf(stderr, "%s: Must specify input log file with -f.\n", argv[0]);
+    exit(1);
+  }
+
+  if ((logfile = fopen(input_fname, "r")) == NULL) {
+    fprintf(stderr, "%s: Cannot open logfile %s.\n", argv[0], input_fname);
+    exit(1);
+  }
+
+  while(!feof(logfile)) {
+    net_vframe vf;
+
+    int bsize = fread((char *) &vf, sizeof(char), net_vision_out_maxsize,
+		      logfile);
+    if (bsize != net_vision_out_maxsize) break;
+    if (vf.msgtype != NET_VISION_FRAME) continue;
+
+    frames.push_back(vf);
+  }
+
+  fclose(logfile);
+
+  int n = frames.size();
+
+  if (n < 4 * window + 2) {
+    fprintf(stderr, "%s: Log %s is too short (%d frames).\n",
+	    argv[0], input_fname, n);
+    exit(1);
+  }
+
+  // Reference velocity from a centered difference of raw observations.
+  vector<vector2d> vref(n);
+  vector<bool> vref_valid(n, false);
+
+  for(int k = window; k < n - window; k++) {
+    net_vframe &f0 = frames[k - window], &f1 = frames[k + window];
+
+    if (!ball_seen(f0) || !ball_seen(f1)) continue;
+    if (f1.timestamp <= f0.timestamp) continue;
+
+    vref[k] = vector2d(f1.ball.vision.pos.x - f0.ball.vision.pos.x,
+		       f1.ball.vision.pos.y - f0.ball.vision.pos.y) /
+      (f1.timestamp - f0.timestamp);
+    vref_valid[k] = true;
+  }
+
+  // Run both trackers over the log.
+  vector<vector2d> vest[2];
+  double cpu[2] = { 0.0, 0.0 };
+  timer tm;
+
+  trackers[0].ball.set_hypotheses(false);
+  trackers[1].ball.set_hypotheses(true);
+
+  for(int j = 0; j < 2; j++) {
+    vest[j].resize(n);
+
+    for(int k = 0; k < n; k++) {
+      if (k == 0 || memcmp(&frames[k].config, &frames[k - 1].config,
+			   sizeof(net_vconfig)) != 0)
+	trackers[j].SetConfig(frames[k].config);
+
+      tm.start();
+      observe(trackers[j], frames[k]);
+      tm.end();
+      cpu[j] += tm.time();
+
+      vest[j][k] = trackers[j].ball.velocity(0.0);
+    }
+  }
+
+  // Find kicks and measure frames to converge.
+  int nkicks = 0;
+  int converge_frames[2] = { 0, 0 };
+  int unconverged[2] = { 0, 0 };
+  int last_kick = -n;
+
+  for(int k = window + 1; k < n - 2 * window; k++) {
+    if (k - last_kick <= 2 * window + 1) continue;
+    if (!vref_valid[k - window - 1] || !vref_valid[k + window]) continue;
+    if ((vref[k + window] - vref[k - window - 1]).length() < kick_threshold)
+      continue;
+
+    last_kick = k;
+    nkicks++;
+
+    for(int j = 0; j < 2; j++) {
+      int i;
+
+      for(i = 0; i < MAX_CONVERGE_FRAMES && k + i < n - window; i++) {
+	int r = max(k + i, k + window);
+
+	if (!vref_valid[r]) continue;
+	if ((vest[j][k + i] - vref[r]).length() < tolerance) break;
+      }
+
+      if (i < MAX_CONVERGE_FRAMES && k + i < n - window)
+	converge_frames[j] += i;
+      else
+	unconverged[j]++;
+    }
+  }
+
+  printf("%d frames, %d kicks\n", n, nkicks);
+  printf("%-20s %18s %12s %12s\n", "",
+	 "frames-to-converge", "unconverged", "usec/frame");
+
+  for(int j = 0; j < 2; j++) {
+    int converged = nkicks - unconverged[j];
+
+    printf("%-20s %18.2f %12d %12.1f\n", tracker_names[j],
+	   converged ? converge_frames[j] / (double) converged : 0.0,
+	   unconverged[j], cpu[j] / n * 1.0E6);
+  }
+
+  return (0);
+}
@@ -0,0 +1,216 @@
+// plan_bench.cc
+//
+// Runs path_planner offline over a corpus of planning problems, either
+// captured from nav_to_point in play (see PLAN_CAPTURE in robot.cfg)
+// or generated here, with fixed seeds.  Prints one line per plan and
+// a summary, as name=value pairs, so that planner changes can be
+// compared run against run.
+//
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <vector>
+
+#include "constants.h"
+#include "configreader.h"
+#include "timer.h"
+#include "../soccer/distance_field.h"
+#include "../soccer/path_planner.h"
+
+/*********************** GLOBALS *****************************/
+
+vector<plan_scenario> scenarios;
+
+distance_field field;
+path_planner planner;
+
+/*********************** CODE ********************************/
+
+static vector2f random_pos(double margin)
+{
+  vector2f p;
+
+  // anywhere on the field outside the defense zones
+  do{
+    p.set((FIELD_LENGTH_H - margin) * (2*drand48() - 1),
+          (FIELD_WIDTH_H - margin) * (2*drand48() - 1));
+  }while(fabs(p.x) > FIELD_LENGTH_H - DEFENSE_DEPTH - margin &&
+         fabs(p.y) < DEFENSE_WIDTH_H + margin);
+
+  return(p);
+}
+
+// Problems like nav_to_point's in open play: the other robots in our
+// way, the ball, walls and defense zones.
+static void generate(int n, long seed, FILE *out)
+{
+  plan_scenario s;
+  vector2f p, v;
+
+  srand48(seed);
+
+  for(int k = 0; k < n; k++) {
+    s.robot = k % MAX_TEAM_ROBOTS;
+    s.mask = 1;
+    s.obs.clear();
+
+    for(int i = 0; i < 2 * MAX_TEAM_ROBOTS - 1; i++) {
+      p = random_pos(100);
+      v.set(500 * (2*drand48() - 1), 500 * (2*drand48() - 1));
+      s.obs.add_circle(p.x, p.y, (i < MAX_TEAM_ROBOTS - 1) ? 110 : 100,
+		       v.x, v.y, 1);
+    }
+
+    p = random_pos(50);
+    s.obs.add_circle(p.x, p.y, 30 + 30 * drand48(), 0, 0, 1);
+    s.obs.add_static(field, OBS_WALLS | OBS_OUR_DZONE | OBS_THEIR_DZONE, 1);
+    s.obs.set_mask(1);
+
+    mzero(s.initial);
+    mzero(s.goal);
+    s.initial.pos = random_pos(150);
+    s.goal.pos = random_pos(150);
+    s.vel.set(0, 0);
+
+    s.write(out);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  char *input_fname = NULL;
+  FILE *in;
+  int nseeds = 5;
+  int ngenerate = 0;
+  long gen_seed = 1;
+  bool quiet = false;
+
+  char c;
+
+  while((c = getopt(argc, argv, "f:s:g:S:qh")) != EOF) {
+    switch (c) {
+    case 'f': input_fname = optarg; break;
+    case 's': nseeds = atoi(optarg); break;
+    case 'g': ngenerate = atoi(optarg); break;
+    case 'S': gen_seed = atol(optarg); break;
+    case 'q': quiet = true; break;
+    case 'h':
+    default:
+      if (argc > 1)
+	fprintf(stderr, "%s: Unknown option -%c.", argv[0], c);
+      fprintf(stderr, "USAGE: plan_bench -f <filename> [options]\n");
+      fprintf(stderr, "       plan_bench -g <n> [-S <seed>] > <filename>\n");
+      fprintf(stderr, "\t-f <filename>\t scenario file\n");
+      fprintf(stderr, "\t-s <n>\t\t planner seeds per scenario "
+	      "(default 5)\n");
+      fprintf(stderr, "\t-q\t\t print only the summary\n");
+      fprintf(stderr, "\t-g <n>\t\t write n generated scenarios\n");
+      fprintf(stderr, "\t-S <seed>\t seed for -g (default 1)\n");
+      exit(1);
+    }
+  }
+
+  field.init();
+
+  if (ngenerate > 0) {
+    generate(ngenerate, gen_seed, stdout);
+    return (0);
+  }
+
+  if (!input_fname) {
+    fprintf(stderr, "%s: Must specify scenario file with -f.\n", argv[0]);
+    exit(1);
+  }
+
+  if ((in = fopen(input_fname, "r")) == NULL) {
+    fprintf(stderr, "%s: Cannot open scenario file %s.\n",
+	    argv[0], input_fname);
+    exit(1);
+  }
+
+  plan_scenario s;
+  while(s.read(in, field)) scenarios.push_back(s);
+
+  if (!feof(in)) {
+    fprintf(stderr, "%s: Bad scenario %d in %s.\n",
+	    argv[0], (int) scenarios.size() + 1, input_fname);
+    exit(1);
+  }
+
+  fclose(in);
+
+  if (scenarios.empty()) {
+    fprintf(stderr, "%s: No scenarios in %s.\n", argv[0], input_fname);
+    exit(1);
+  }
+
+  // Each plan starts from a freshly seeded planner, so runs repeat
+  // exactly and nothing is reused from the plan before.
+  int nplans = 0, nsuccess = 0;
+  double total_length = 0.0, total_nodes = 0.0, total_time = 0.0;
+  timer tm;
+
+  for(uint k = 0; k < scenarios.size(); k++) {
+    plan_scenario &sc = scenarios[k];
+
+    for(int seed = 1; seed <= nseeds; seed++) {
+      state target;
+      int obs_id = -1;
+
+      srand48(seed);
+      planner.init(400, 100, 0.15, 0.75, 100);
+
+      tm.start();
+      target = planner.plan(&sc.obs, sc.mask, sc.initial, sc.goal, obs_id);
+      tm.end();
+
+      bool success = (planner.last_mode == PLAN_DIRECT ||
+		      planner.last_dist < NEAR);
+      double length = planner.path_length(sc.initial);
+
+      // short plans keep no path
+      if (success && length < 0)
+	length = Vector::distance(sc.initial.pos, sc.goal.pos);
+
+      nplans++;
+      total_time += tm.time();
+      total_nodes += planner.nodes();
+      if (success) {
+	nsuccess++;
+	total_length += length;
+      }
+
+      if (!quiet)
+	printf("scenario=%d seed=%d robot=%d mode=%d success=%d "
+	       "length=%.1f nodes=%d ns=%.0f\n",
+	       k, seed, sc.robot, planner.last_mode, success ? 1 : 0,
+	       success ? length : -1.0, planner.nodes(), tm.time() * 1.0E9);
+    }
+  }
+
+  printf("plans=%d success_rate=%.4f mean_length=%.1f mean_nodes=%.1f "
+	 "ns_per_plan=%.0f\n",
+	 nplans, (double) nsuccess / nplans,
+	 (nsuccess > 0) ? total_length / nsuccess : 0.0,
+	 total_nodes / nplans, total_time / nplans * 1.0E9);
+
+  return (0);
+}
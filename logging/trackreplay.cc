@@ -0,0 +1,357 @@
+// trackreplay.cc
+//
+// Runs the tracker offline over the raw observations in a vision log
+// as fast as possible.  Reports the tracker's CPU time per frame and
+// its prediction error at one or more lookaheads, optionally sweeping
+// tracker.cfg parameters.  Each (parameter setting, lookahead) pair
+// is replayed in its own process, so sweeps use all cores.
+//
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <vector>
+
+#include "../reality/net_vision.h"
+#include "constants.h"
+#include "configreader.h"
+#include "vtracker.h"
+#include "timer.h"
+
+#define MAX_SWEEP_PARAMS 4
+#define MAX_SWEEP_VALUES 32
+
+/*********************** TYPES *******************************/
+
+struct sweep_param {
+  char *name;
+  int nvalues;
+  double values[MAX_SWEEP_VALUES];
+};
+
+struct replay_job {
+  double lookahead;
+  int value_index[MAX_SWEEP_PARAMS];
+};
+
+struct replay_result {
+  bool ok;
+  double usec_per_frame;
+  double ball_pos, ball_vel;
+  double robot_pos, robot_theta, robot_vel;
+  int ball_n, robot_n;
+};
+
+/*********************** GLOBALS *****************************/
+
+vector<net_vframe> frames;
+
+sweep_param params[MAX_SWEEP_PARAMS];
+int nparams = 0;
+
+VTracker tracker;
+
+/*********************** CODE ********************************/
+
+static int parse_list(char *str, double *values, int max_values)
+{
+  int n = 0;
+
+  for(char *s = strtok(str, ","); s && n < max_values; s = strtok(NULL, ","))
+    values[n++] = atof(s);
+
+  return n;
+}
+
+static bool set_param(const char *name, double value)
+{
+  for(uint i=0; i<configreader.datamap.size(); i++) {
+    DataMap *d = configreader.datamap[i];
+
+    if (strcmp(d->dataname, name) != 0) continue;
+
+    switch(d->type) {
+    case CR_DOUBLE: d->data.ddata[0] = value; return true;
+    case CR_INT: d->data.idata[0] = (int) rint(value); return true;
+    default: return false;
+    }
+  }
+
+  return false;
+}
+
+static void replay(replay_job &job, replay_result &r)
+{
+  timer tm;
+  double cpu = 0.0;
+
+  r.ok = true;
+
+  // Error printing in the trackers would reset the statistics.
+  set_param("BALL_PRINT_KALMAN_ERROR", 0);
+  set_param("ROBOT_PRINT_KALMAN_ERROR", 0);
+
+  for(int p=0; p<nparams; p++) {
+    if (!set_param(params[p].name, params[p].values[job.value_index[p]])) {
+      fprintf(stderr, "trackreplay: Unknown parameter %s.\n", params[p].name);
+      r.ok = false;
+      return;
+    }
+  }
+
+  tracker.ball.set_error_lookahead(job.lookahead);
+  for(int t = 0; t < NUM_TEAMS; t++)
+    for(int i = 0; i < MAX_TEAM_ROBOTS; i++)
+      tracker.robots[t][i].set_error_lookahead(job.lookahead);
+
+  for(uint k = 0; k < frames.size(); k++) {
+    net_vframe &vf = frames[k];
+
+    if (k == 0 || memcmp(&vf.config, &frames[k - 1].config,
+			 sizeof(net_vconfig)) != 0)
+      tracker.SetConfig(vf.config);
+
+    tm.start();
+
+    tracker.ball.observe(vf.ball.vision, vf.timestamp);
+
+    for(int t = 0; t < NUM_TEAMS; t++) {
+      for(int i = 0; i < MAX_TEAM_ROBOTS; i++) {
+	if (vf.config.teams[t].robots[i].id >= 0)
+	  tracker.robots[t][i].observe(vf.robots[t][i].vision, vf.timestamp);
+      }
+    }
+
+    tm.end();
+    cpu += tm.time();
+  }
+
+  r.usec_per_frame = cpu / frames.size() * 1.0E6;
+
+  // Ball errors.
+  r.ball_n = tracker.ball.prediction_error_count();
+  r.ball_pos = r.ball_vel = 0.0;
+
+  if (r.ball_n > 0) {
+    Matrix e = tracker.ball.prediction_error();
+    r.ball_pos = hypot(e.e(0, 0), e.e(1, 0));
+    r.ball_vel = hypot(e.e(2, 0), e.e(3, 0));
+  }
+
+  // Robot errors, weighted by each robot's number of samples.
+  r.robot_n = 0;
+  r.robot_pos = r.robot_theta = r.robot_vel = 0.0;
+
+  for(int t = 0; t < NUM_TEAMS; t++) {
+    for(int i = 0; i < MAX_TEAM_ROBOTS; i++) {
+      int n = tracker.robots[t][i].prediction_error_count();
+      if (n <= 0) continue;
+
+      Matrix e = tracker.robots[t][i].prediction_error();
+      r.robot_pos += n * hypot(e.e(0, 0), e.e(1, 0));
+      r.robot_theta += n * e.e(2, 0);
+      r.robot_vel += n * hypot(e.e(3, 0), e.e(4, 0));
+      r.robot_n += n;
+    }
+  }
+
+  if (r.robot_n > 0) {
+    r.robot_pos /= r.robot_n;
+    r.robot_theta /= r.robot_n;
+    r.robot_vel /= r.robot_n;
+  }
+}
+
+static void print_result(replay_job &job, replay_result &r)
+{
+  for(int p=0; p<nparams; p++)
+    printf("%s=%g ", params[p].name, params[p].values[job.value_index[p]]);
+
+  if (!r.ok) {
+    printf("lookahead=%g failed\n", job.lookahead);
+    return;
+  }
+
+  printf("lookahead=%g usec_per_frame=%.1f "
+	 "ball_pos=%.2f ball_vel=%.2f ball_n=%d "
+	 "robot_pos=%.2f robot_theta=%.4f robot_vel=%.2f robot_n=%d\n",
+	 job.lookahead, r.usec_per_frame,
+	 r.ball_pos, r.ball_vel, r.ball_n,
+	 r.robot_pos, r.robot_theta, r.robot_vel, r.robot_n);
+}
+
+int main(int argc, char *argv[])
+{
+  char *input_fname = NULL;
+  FILE *logfile = NULL;
+  double lookaheads[MAX_SWEEP_VALUES] = { LATENCY_DELAY };
+  int nlookaheads = 1;
+  int njobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+  char c;
+  char *eq;
+
+  while((c = getopt(argc, argv, "f:l:p:j:h")) != EOF) {
+    switch (c) {
+    case 'f': input_fname = optarg; break;
+    case 'l':
+      nlookaheads = parse_list(optarg, lookaheads, MAX_SWEEP_VALUES);
+      break;
+    case 'p':
+      if (nparams >= MAX_SWEEP_PARAMS || !(eq = strchr(optarg, '='))) {
+	fprintf(stderr, "%s: Bad or too many -p options.\n", argv[0]);
+	exit(1);
+      }
+      *eq = '\0';
+      params[nparams].name = optarg;
+      params[nparams].nvalues = parse_list(eq + 1, params[nparams].values,
+					   MAX_SWEEP_VALUES);
+      nparams++;
+      break;
+    case 'j': njobs = atoi(optarg); break;
+    case 'h':
+    default:
+      if (argc > 1)
+	fprintf(stderr, "%s: Unknown option -%c.", argv[0], c);
+      fprintf(stderr, "USAGE: trackreplay -f <filename> [options]\n");
+      fprintf(stderr, "\t-f <filename>\t input log file\n");
+      fprintf(stderr, "\t-l <t1,t2,...>\t prediction lookaheads in seconds "
+	      "(default %g)\n", LATENCY_DELAY);
+      fprintf(stderr, "\t-p <NAME=v1,v2,...>\t sweep a tracker.cfg "
+	      "parameter (up to %d)\n", MAX_SWEEP_PARAMS);
+      fprintf(stderr, "\t-j <n>\t\t parallel replays (default: #cpus)\n");
+      exit(1);
+    }
+  }
+
+  if (!input_fname) {
+    fprintf(stderr, "%s: Must specify input log file with -f.\n", argv[0]);
+    exit(1);
+  }
+
+  if ((logfile = fopen(input_fname, "r")) == NULL) {
+    fprintf(stderr, "%s: Cannot open logfile %s.\n", argv[0], input_fname);
+    exit(1);
+  }
+
+  while(!feof(logfile)) {
+    net_vframe vf;
+
+    int bsize = fread((char *) &vf, sizeof(char), net_vision_out_maxsize,
+		      logfile);
+    if (bsize != net_vision_out_maxsize) break;
+    if (vf.msgtype != NET_VISION_FRAME) continue;
+
+    frames.push_back(vf);
+  }
+
+  fclose(logfile);
+
+  if (frames.empty()) {
+    fprintf(stderr, "%s: No frames in %s.\n", argv[0], input_fname);
+    exit(1);
+  }
+
+  if (njobs < 1) njobs = 1;
+
+  // Build the cartesian product of lookaheads and parameter values.
+  vector<replay_job> jobs;
+  replay_job job;
+
+  memset(&job, 0, sizeof(job));
+
+  for(int l = 0; l < nlookaheads; l++) {
+    job.lookahead = lookaheads[l];
+
+    for(int p = 0; p < nparams; p++) job.value_index[p] = 0;
+
+    while(true) {
+      jobs.push_back(job);
+
+      int p;
+      for(p = 0; p < nparams; p++) {
+	if (++job.value_index[p] < params[p].nvalues) break;
+	job.value_index[p] = 0;
+      }
+      if (p == nparams) break;
+    }
+  }
+
+  // Run each job in its own process.  Config variables are global, so
+  // this keeps the parameter settings of different jobs apart.
+  vector<replay_result> results(jobs.size());
+  vector<pid_t> pids(jobs.size(), 0);
+  vector<int> fds(jobs.size(), -1);
+  uint next = 0;
+  int running = 0;
+
+  fprintf(stderr, "Replaying %d frames, %d configurations, %d at a time.\n",
+	  (int) frames.size(), (int) jobs.size(), njobs);
+
+  while(next < jobs.size() || running > 0) {
+    if (next < jobs.size() && running < njobs) {
+      int fd[2];
+
+      if (pipe(fd) < 0) { perror("pipe"); exit(1); }
+
+      pid_t pid = fork();
+
+      if (pid < 0) { perror("fork"); exit(1); }
+
+      if (pid == 0) {
+	replay_result r;
+
+	close(fd[0]);
+	replay(jobs[next], r);
+	write(fd[1], &r, sizeof(r));
+	_exit(0);
+      }
+
+      close(fd[1]);
+      pids[next] = pid; fds[next] = fd[0];
+      next++; running++;
+      continue;
+    }
+
+    int status;
+    pid_t pid = wait(&status);
+    if (pid < 0) break;
+
+    for(uint i = 0; i < jobs.size(); i++) {
+      if (pids[i] != pid) continue;
+
+      if (read(fds[i], &results[i], sizeof(replay_result)) !=
+	  sizeof(replay_result)) results[i].ok = false;
+
+      close(fds[i]);
+      running--;
+      break;
+    }
+  }
+
+  for(uint i = 0; i < jobs.size(); i++)
+    print_result(jobs[i], results[i]);
+
+  return (0);
+}
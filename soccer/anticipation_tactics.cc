@@ -93,9 +93,7 @@ double TPositionForRebound::eval_fn(World &world, const vector2d p,
   
   if (world.obsPosition(p, obs_flags)) { a = 0.0; return -1; } 
 
-  if (evaluation.aim(world, world.now, p, 
-		     world.their_goal_r, world.their_goal_l, 
-		     OBS_OPPONENTS, target, tolerance)) {
+  if (evaluation.aim_shot(world, p, target, tolerance)) {
     a = (target - p).angle();
 
     return tolerance;
@@ -132,6 +130,14 @@ double TPositionForPass::eval_fn(World &world, const vector2d p,
 
   a = (ball - p).angle();
 
+  // Passes past the opponents alone are on the grid, and can only be
+  // more open than with the teammates too.  Interpolating would mark
+  // an open point next to a blocked cell as closed, so this only
+  // gives up if all the cells around p are.
+  double open;
+  if (world.quality.pass_max(p, open) && open < sin(25.0 / ball2p.length()))
+    return -1;
+
   if (!evaluation.aim(world, world.now, ball, 
 		      ball + ball2p + ball2p.perp().norm(30.0),
 		      ball + ball2p + ball2p.perp().norm(-30.0), obs_flags,
@@ -177,6 +183,14 @@ double TPositionForDeflection::eval_fn(World &world, const vector2d p,
 
   a = (ball - p).angle() / 2.0;
 
+  // Passes past the opponents alone are on the grid, and can only be
+  // more open than with the teammates too.  Interpolating would mark
+  // an open point next to a blocked cell as closed, so this only
+  // gives up if all the cells around p are.
+  double open;
+  if (world.quality.pass_max(p, open) && open < sin(25.0 / ball2p.length()))
+    return -1;
+
   if (!evaluation.aim(world, world.now, ball, 
 		      ball + ball2p + ball2p.perp().norm(30.0),
 		      ball + ball2p + ball2p.perp().norm(-30.0), obs_flags,
@@ -0,0 +1,249 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "assignment.h"
+
+bool min_cost_assignment(int n,int m,const double *cost,int *col_of,
+			 double *total)
+{
+  // Row and column potentials, with row 0 and column 0 as sentinels,
+  // so rows and columns are numbered from 1 here.
+  double u[ASSIGN_MAX + 1],v[ASSIGN_MAX + 1],minv[ASSIGN_MAX + 1];
+  int row_of[ASSIGN_MAX + 1],way[ASSIGN_MAX + 1];
+  bool used[ASSIGN_MAX + 1];
+  int i,j;
+
+  if (n < 0 || m < n || m > ASSIGN_MAX) return(false);
+
+  for(j=0; j<=m; j++) v[j] = 0.0, row_of[j] = 0;
+  for(i=0; i<=n; i++) u[i] = 0.0;
+
+  // Add the rows one at a time, each along the cheapest augmenting
+  // path in the reduced costs.
+  for(i=1; i<=n; i++) {
+    int j0 = 0;
+    row_of[0] = i;
+
+    for(j=0; j<=m; j++) minv[j] = HUGE_VAL, used[j] = false;
+
+    do {
+      int i0 = row_of[j0],j1 = 0;
+      double delta = HUGE_VAL;
+
+      used[j0] = true;
+
+      for(j=1; j<=m; j++) {
+	if (used[j]) continue;
+
+	double c = cost[(i0 - 1) * m + (j - 1)] - u[i0] - v[j];
+	if (c < minv[j]) minv[j] = c, way[j] = j0;
+	if (minv[j] < delta) delta = minv[j], j1 = j;
+      }
+
+      for(j=0; j<=m; j++) {
+	if (used[j]) {
+	  u[row_of[j]] += delta;
+	  v[j] -= delta;
+	} else {
+	  minv[j] -= delta;
+	}
+      }
+
+      j0 = j1;
+    } while(row_of[j0] != 0);
+
+    // flip the path
+    do {
+      int j1 = way[j0];
+      row_of[j0] = row_of[j1];
+      j0 = j1;
+    } while(j0 != 0);
+  }
+
+  double sum = 0.0;
+
+  for(j=1; j<=m; j++) {
+    if (row_of[j] == 0) continue;
+    col_of[row_of[j] - 1] = j - 1;
+    sum += cost[(row_of[j] - 1) * m + (j - 1)];
+  }
+
+  if (total) *total = sum;
+
+  return(true);
+}
+
+void assign_rows(int n,int m,const double *cost,int *col_of)
+{
+  if (min_cost_assignment(n,m,cost,col_of)) return;
+
+  for(int k=0; k<n; k++) col_of[k] = k;
+}
+
+#ifdef TEST_MAIN
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+// Checks min_cost_assignment() against trying every assignment on
+// random problems, checks assign_rows() on role costs like the play
+// executor's, and times it on the executor's 4x5.
+
+#define TEST_PROBLEMS 20000
+#define TEST_TIMED    200000
+
+// as in strategy.cfg and tactic.h
+#define TEST_ROLE_WEIGHT 4.0
+#define TEST_SWITCH_COST 0.3
+#define TEST_UNFIT_COST  100.0
+
+static double best_total;
+static int best_col_of[ASSIGN_MAX];
+static int col_try[ASSIGN_MAX];
+
+static void search(int n,int m,const double *cost,int row,
+		   bool *taken,double total)
+{
+  if (row == n) {
+    if (total < best_total) {
+      best_total = total;
+      for(int i=0; i<n; i++) best_col_of[i] = col_try[i];
+    }
+    return;
+  }
+
+  for(int j=0; j<m; j++) {
+    if (taken[j]) continue;
+    taken[j] = true;
+    col_try[row] = j;
+    search(n,m,cost,row + 1,taken,total + cost[row * m + j]);
+    taken[j] = false;
+  }
+}
+
+static double get_time()
+{
+  timeval tv;
+  gettimeofday(&tv,NULL);
+  return(tv.tv_sec + tv.tv_usec * 1.0E-6);
+}
+
+int main(int argc,char **argv)
+{
+  double cost[ASSIGN_MAX * ASSIGN_MAX];
+  bool taken[ASSIGN_MAX];
+  int col_of[ASSIGN_MAX];
+  int wrong = 0;
+
+  srand48(1);
+
+  for(int k=0; k<TEST_PROBLEMS; k++) {
+    int m = 1 + lrand48() % 6;
+    int n = 1 + lrand48() % m;
+
+    for(int i=0; i<n*m; i++) {
+      // some ties and some negatives
+      cost[i] = (lrand48() % 4 == 0)? 1.0 : drand48() * 10.0 - 2.0;
+    }
+
+    double total;
+    if (!min_cost_assignment(n,m,cost,col_of,&total)) total = HUGE_VAL;
+
+    for(int j=0; j<m; j++) taken[j] = false;
+    for(int i=0; i<n; i++) {
+      if (taken[col_of[i]]) total = HUGE_VAL; // not one to one
+      taken[col_of[i]] = true;
+    }
+
+    best_total = HUGE_VAL;
+    for(int j=0; j<m; j++) taken[j] = false;
+    search(n,m,cost,0,taken,0.0);
+
+    if (fabs(total - best_total) > 1E-9) wrong++;
+  }
+
+  printf("%d of %d problems not solved exactly\n",wrong,TEST_PROBLEMS);
+
+  // Roles as the play executor weighs them once the robots have
+  // settled: estimated times near 0, the current robot of each role
+  // biased by -TEST_SWITCH_COST, and sometimes a role that keeps its
+  // robot at -TEST_UNFIT_COST, so most totals are below 0.  The
+  // assignment must be the least, not row k to column k.
+  int role_wrong = 0,negative = 0;
+
+  for(int k=0; k<TEST_PROBLEMS; k++) {
+    int m = 2 + lrand48() % 4;
+    int n = 1 + lrand48() % (m - 1);
+    int current[ASSIGN_MAX];
+    double weight = 1.0;
+
+    for(int j=0; j<m; j++) taken[j] = false;
+    for(int i=0; i<n; i++) {
+      do current[i] = lrand48() % m; while(taken[current[i]]);
+      taken[current[i]] = true;
+    }
+
+    for(int i=n-1; i>=0; i--) {
+      bool unfit = (lrand48() % 3 == 0);
+
+      for(int j=0; j<m; j++) {
+	double c = drand48() * 0.2;
+	if (j == current[i]) c -= unfit ? TEST_UNFIT_COST : TEST_SWITCH_COST;
+	cost[i * m + j] = weight * c;
+      }
+      weight *= TEST_ROLE_WEIGHT;
+    }
+
+    assign_rows(n,m,cost,col_of);
+
+    double total = 0.0;
+    for(int i=0; i<n; i++) total += cost[i * m + col_of[i]];
+
+    best_total = HUGE_VAL;
+    for(int j=0; j<m; j++) taken[j] = false;
+    search(n,m,cost,0,taken,0.0);
+
+    if (best_total < 0.0) negative++;
+    if (fabs(total - best_total) > 1E-9) role_wrong++;
+    else {
+      // without ties, the same robots
+      for(int i=0; i<n; i++) 
+	if (col_of[i] != best_col_of[i]) { role_wrong++; break; }
+    }
+  }
+
+  printf("%d of %d role assignments not least (%d below 0)\n",
+	 role_wrong,TEST_PROBLEMS,negative);
+  wrong += role_wrong;
+
+  for(int i=0; i<4*5; i++) cost[i] = drand48() * 5.0;
+
+  double t = get_time();
+  for(int k=0; k<TEST_TIMED; k++) {
+    cost[k % 20] = drand48() * 5.0;
+    min_cost_assignment(4,5,cost,col_of);
+  }
+  t = get_time() - t;
+
+  printf("4x5: %.3f us each\n",t / TEST_TIMED * 1E6);
+
+  return(wrong != 0);
+}
+
+#endif
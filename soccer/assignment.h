@@ -0,0 +1,38 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// Minimum cost assignment (the Hungarian method), for handing out a
+// play's roles to robots.  Small problems only: it takes O(n^2 m).
+
+#ifndef __ASSIGNMENT_H__
+#define __ASSIGNMENT_H__
+
+// Most rows or columns min_cost_assignment() takes.
+#define ASSIGN_MAX 8
+
+// Gives each of the n rows a different one of the m columns (n <= m)
+// so that the sum of cost[row * m + col] is least.  Sets col_of[] for
+// each row, and the total if asked for, and returns true; or returns
+// false and leaves them alone if n or m is out of range.  Costs may be
+// negative.
+bool min_cost_assignment(int n,int m,const double *cost,int *col_of,
+			 double *total = NULL);
+
+// As min_cost_assignment(), but if it can't, gives row k column k, so
+// col_of[] is always set.  The play executor hands out roles with it.
+void assign_rows(int n,int m,const double *cost,int *col_of);
+
+#endif /*__ASSIGNMENT_H__*/
@@ -213,9 +213,7 @@ double TShoot::eval_fn(World &world, const vector2d p,
 
   if (world.obsLine(p, world.ball_position(), obs_flags)) { return -1; }
 
-  if (evaluation.aim(world, world.now, p, 
-		     world.their_goal_r, world.their_goal_l, 
-		     OBS_OPPONENTS, target, tolerance)) {
+  if (evaluation.aim_shot(world, p, target, tolerance)) {
     a = (target - p).angle();
 
     return tolerance;
@@ -446,9 +444,7 @@ double TDribbleToShoot::eval_fn(World &world, const vector2d p,
   
   if (world.obsPosition(p, obs_flags)) { a = 0.0; return -1; } 
   
-  if (evaluation.aim(world, world.now, p, 
-		     world.their_goal_r, world.their_goal_l, 
-		     OBS_OPPONENTS, target, tolerance)) {
+  if (evaluation.aim_shot(world, p, target, tolerance)) {
     a = (target - p).angle();
     
     return tolerance;
@@ -52,21 +52,23 @@ public:
   static Tactic *parser(const char *param_string);
   virtual Tactic *clone() const { return new TShoot(*this); }
 
-  virtual int selectRobot(World &world, bool candidates[], double bias[]) {
+  virtual void roleCosts(World &world, bool candidates[], double bias[],
+			 double times[], double costs[]) {
+    Tactic::roleCosts(world, candidates, bias, times, costs);
+
+    // Deflections want an omni robot, if there is one.
     if (type == Deflect) {
-      bool mycandidates[MAX_TEAM_ROBOTS];
       bool omni_candidate = false;
 
       for(int i=0; i<MAX_TEAM_ROBOTS; i++)
-	if (candidates[i] && world.teammate_type(i) == ROBOT_TYPE_OMNI) {
-	  mycandidates[i] = true; omni_candidate = true;
-	} else mycandidates[i] = false;
+	if (candidates[i] && world.teammate_type(i) == ROBOT_TYPE_OMNI)
+	  omni_candidate = true;
 
-      if (omni_candidate) 
-	return Tactic::selectRobot(world, mycandidates, bias);
+      if (omni_candidate)
+	for(int i=0; i<MAX_TEAM_ROBOTS; i++)
+	  if (world.teammate_type(i) != ROBOT_TYPE_OMNI)
+	    costs[i] += TACTIC_UNFIT_COST;
     }
-
-    return Tactic::selectRobot(world, candidates, bias);
   }
 
   virtual void command(World &world, int me, Robot::RobotCommand &command,
@@ -25,8 +25,13 @@
 
 #include "parse.h"
 #include "evaluation.h"
+#include "intercept.h"
 #include "defense_tactics.h"
 
+// How far ahead block looks for a teammate meeting the ball, as
+// defend_line() looks for where to intercept it.
+#define P_BlockLookahead 1.0
+
 CR_DECLARE(DEFENSE_OFF_BALL);
 CR_DECLARE(MARK_OFF_OPPONENT);
 
@@ -68,7 +73,7 @@ void TDefendLine::command(World &world, int me, Robot::RobotCommand &command,
   // Position
   if (!evaluation.defend_line(world, world.now, v[0], v[1],
 			      distmin, distmax, DVAR(DEFENSE_OFF_BALL), 
-			      intercepting, target, velocity)) {
+			      intercepting, target, velocity, me)) {
     if (debug) {
       gui_debug_printf(me, GDBG_TACTICS, 
         "DefendLine: WARNING evaluation.defend_line() returned false.");
@@ -154,7 +159,7 @@ void TDefendPoint::command(World &world, int me, Robot::RobotCommand &command,
   // Position
   if (!evaluation.defend_point(world, world.now, centerv, 
 			       distmin, distmax, DVAR(DEFENSE_OFF_BALL),
-			       intercepting, target, velocity)) {
+			       intercepting, target, velocity, me)) {
     if (debug) {
       gui_debug_printf(me, GDBG_TACTICS, 
         "DefendCircle: WARNING evaluation.defend_line() returned false.");
@@ -290,13 +295,22 @@ void TBlock::command(World &world, int me, Robot::RobotCommand &command,
   vector2d target, velocity;
   double angle;
 
-  vector2d pref_point;
+  vector2d pref_point, habit_point;
+  double pref_amount = 0.1221, habit_amount;
 
-  // Side preference
+  // Side preference, or else where their shots tend to go
   if (prefside != 0) 
     pref_point = vector2d(world.our_goal_l.x, 
 			  world.our_goal_l.y * prefside * world.sideBall());
-  else if (!pref_point_set) pref_point = world.our_goal;
+  else if (evaluation.shot_habit(world, habit_point, habit_amount)) {
+    pref_point = habit_point;
+    if (habit_amount > pref_amount) pref_amount = habit_amount;
+  } else if (!pref_point_set) pref_point = world.our_goal;
+
+  // Leave a moving ball to a teammate who gets to it first.
+  ball_intercept intercepts[MAX_TEAM_ROBOTS];
+  int first = intercept_ball(world, world.now, P_BlockLookahead, intercepts);
+  if (first >= 0 && first != me) intercepting = false;
 
   // Take into account teammates behind us.
   int obs_flags = 0;
@@ -309,11 +323,11 @@ void TBlock::command(World &world, int me, Robot::RobotCommand &command,
   // Position
   if (!evaluation.defend_line(world, world.now, v[0], v[1],
 			      distmin, distmax, DVAR(DEFENSE_OFF_BALL),
-			      intercepting, obs_flags, pref_point, 0.1221,
-			      target, velocity) &&
+			      intercepting, obs_flags, pref_point, pref_amount,
+			      target, velocity, me) &&
       !evaluation.defend_line(world, world.now, v[0], v[1],
 			      distmin, distmax, DVAR(DEFENSE_OFF_BALL),
-			      intercepting, target, velocity)) {
+			      intercepting, target, velocity, me)) {
     if (debug) 
       gui_debug_printf(me, GDBG_TACTICS, 
 		       "Block: WARNING evaluation.defend_line() returned false.");
@@ -0,0 +1,209 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include "geometry.h"
+#include "constants.h"
+
+#include "distance_field.h"
+
+// signed distance to a box given by center and half sizes
+static float box_distance(vector2f p,float cx,float cy,float rx,float ry)
+{
+  float dx,dy,ox,oy;
+
+  dx = fabs(p.x - cx) - rx;
+  dy = fabs(p.y - cy) - ry;
+
+  if(dx<=0 && dy<=0) return((dx > dy)? dx : dy);
+
+  ox = (dx > 0)? dx : 0;
+  oy = (dy > 0)? dy : 0;
+  return(sqrt(ox*ox + oy*oy));
+}
+
+static float min2(float a,float b)
+{
+  return((a < b)? a : b);
+}
+
+// Exact distance to the shapes for one flag, as in nav_to_point.
+float distance_field::part_distance(vector2f p,int flag)
+{
+  const float gx = FIELD_LENGTH_H + GOAL_DEPTH;
+  const float gy = (FIELD_WIDTH_H + GOAL_WIDTH_H) / 2;
+  const float gh = (FIELD_WIDTH_H - GOAL_WIDTH_H) / 2;
+  float d;
+
+  switch(flag){
+    case OBS_WALLS:
+      // half planes
+      d = p.x + gx;
+      d = min2(d,gx - p.x);
+      d = min2(d,p.y + FIELD_WIDTH_H);
+      d = min2(d,FIELD_WIDTH_H - p.y);
+
+      // beside the goals
+      d = min2(d,box_distance(p,-gx, gy,GOAL_DEPTH/2,gh));
+      d = min2(d,box_distance(p,-gx,-gy,GOAL_DEPTH/2,gh));
+      d = min2(d,box_distance(p, gx, gy,GOAL_DEPTH/2,gh));
+      d = min2(d,box_distance(p, gx,-gy,GOAL_DEPTH/2,gh));
+      return(d);
+
+    case OBS_OUR_DZONE:
+      return(box_distance(p,-FIELD_LENGTH_H-DEFENSE_DEPTH,0,
+                          DEFENSE_DEPTH*2,DEFENSE_WIDTH_H));
+
+    case OBS_THEIR_DZONE:
+      return(box_distance(p, FIELD_LENGTH_H+DEFENSE_DEPTH,0,
+                          DEFENSE_DEPTH*2,DEFENSE_WIDTH_H));
+  }
+
+  return(1E6);
+}
+
+distance_field::distance_field()
+{
+  int i;
+
+  for(i=0; i<DF_COMBOS; i++) dist[i] = NULL;
+  width = height = 0;
+  minx = miny = 0;
+}
+
+distance_field::~distance_field()
+{
+  int i;
+
+  for(i=0; i<DF_COMBOS; i++) delete[](dist[i]);
+}
+
+void distance_field::init()
+{
+  const int part[3] = {OBS_WALLS,OBS_THEIR_DZONE,OBS_OUR_DZONE};
+  float pd[3];
+  vector2f p;
+  int i,j,k,c;
+  float d;
+
+  minx = -(FIELD_LENGTH_H + GOAL_DEPTH + DF_MARGIN);
+  miny = -(FIELD_WIDTH_H + DF_MARGIN);
+  width  = (int)ceil(-2*minx / DF_RES) + 1;
+  height = (int)ceil(-2*miny / DF_RES) + 1;
+
+  for(c=0; c<DF_COMBOS; c++){
+    delete[](dist[c]);
+    dist[c] = new float[width*height];
+  }
+
+  for(j=0; j<height; j++){
+    for(i=0; i<width; i++){
+      p.set(minx + i*DF_RES,miny + j*DF_RES);
+      for(k=0; k<3; k++) pd[k] = part_distance(p,part[k]);
+
+      for(c=0; c<DF_COMBOS; c++){
+        d = 1E6;
+        for(k=0; k<3; k++){
+          if(c & DF_INDEX(part[k])) d = min2(d,pd[k]);
+        }
+        dist[c][j*width + i] = d;
+      }
+    }
+  }
+}
+
+// Bilinear interpolation of grid d at (x,y), and its gradient.  Points
+// off the grid use its nearest edge.
+float distance_field::lookup(float *d,float x,float y,float &gx,float &gy)
+{
+  float fx,fy,d00,d10,d01,d11;
+  int i,j;
+  float *c;
+
+  fx = (x - minx) / DF_RES;
+  fy = (y - miny) / DF_RES;
+  // written so that NaN lands on the grid too
+  if(!(fx > 0)) fx = 0;
+  if(!(fy > 0)) fy = 0;
+  if(fx > width-1.001f) fx = width-1.001f;
+  if(fy > height-1.001f) fy = height-1.001f;
+
+  i = (int)fx;
+  j = (int)fy;
+  fx -= i;
+  fy -= j;
+
+  c = &d[j*width + i];
+  d00 = c[0];
+  d10 = c[1];
+  d01 = c[width];
+  d11 = c[width+1];
+
+  gx = ((d10 - d00)*(1-fy) + (d11 - d01)*fy) / DF_RES;
+  gy = ((d01 - d00)*(1-fx) + (d11 - d10)*fx) / DF_RES;
+
+  return((d00*(1-fx) + d10*fx)*(1-fy) + (d01*(1-fx) + d11*fx)*fy);
+}
+
+float distance_field::distance(vector2f p,int flags)
+{
+  float gx,gy;
+  int c = DF_INDEX(flags);
+
+  if(c==0 || !dist[c]) return(1E6);
+  return(lookup(dist[c],p.x,p.y,gx,gy));
+}
+
+vector2f distance_field::gradient(vector2f p,int flags)
+{
+  vector2f g;
+  float gx,gy;
+  int c = DF_INDEX(flags);
+
+  g.set(0,0);
+  if(c==0 || !dist[c]) return(g);
+
+  lookup(dist[c],p.x,p.y,gx,gy);
+  g.set(gx,gy);
+  return(g.norm());
+}
+
+// Marches along the segment, each step as long as the clearance at
+// the last point, since nothing can be closer than that.
+bool distance_field::check(vector2f p0,vector2f p1,int flags,float radius)
+{
+  vector2f dir;
+  float *d,l,s,m,gx,gy;
+  int c = DF_INDEX(flags);
+
+  if(c==0 || !dist[c]) return(true);
+  d = dist[c];
+
+  dir = p1 - p0;
+  l = dir.length();
+  if(l > EPSILON) dir *= 1.0 / l;
+
+  s = 0;
+  while(true){
+    m = lookup(d,p0.x + dir.x*s,p0.y + dir.y*s,gx,gy) - radius;
+    if(m <= 0) return(false);
+    if(s >= l) return(true);
+
+    s += (m > DF_RES/4)? m : DF_RES/4;
+    if(s > l) s = l;
+  }
+}
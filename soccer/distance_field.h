@@ -0,0 +1,60 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// Signed distance (negative inside) to the obstacles that never move:
+// the walls and the sides of the goals (OBS_WALLS) and the defense
+// zones (OBS_OUR_DZONE, OBS_THEIR_DZONE), with the same shapes that
+// nav_to_point used to add each frame.  The distances are sampled once
+// on a grid over the field for every combination of those flags and
+// looked up with bilinear interpolation, so checking against them
+// costs the same however many there are.
+
+#ifndef __DISTANCE_FIELD_H__
+#define __DISTANCE_FIELD_H__
+
+#include "geometry.h"
+#include "constants.h"
+
+#define DF_RES    25.0  // grid spacing (mm)
+#define DF_MARGIN 300.0 // grid extends this far beyond the walls (mm)
+
+// the obstacle flags (see constants.h) the field covers
+#define DF_FLAGS  (OBS_WALLS | OBS_THEIR_DZONE | OBS_OUR_DZONE)
+#define DF_INDEX(flags) (((flags) & DF_FLAGS) >> 1)
+#define DF_COMBOS 8
+
+class distance_field{
+  float *dist[DF_COMBOS]; // grid for each DF_INDEX(flags)
+  int width,height;
+  float minx,miny;
+
+  static float part_distance(vector2f p,int flag);
+  float lookup(float *d,float x,float y,float &gx,float &gy);
+public:
+  distance_field();
+  ~distance_field();
+
+  void init();
+
+  // All take obstacle flags, of which only DF_FLAGS are used.
+  float distance(vector2f p,int flags);
+  vector2f gradient(vector2f p,int flags);
+
+  // Whether a robot of the given radius can move from p0 to p1.
+  bool check(vector2f p0,vector2f p1,int flags,float radius);
+};
+
+#endif /*__DISTANCE_FIELD_H__*/
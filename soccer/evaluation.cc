@@ -20,11 +20,38 @@
     including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
   ------------------------------------------------------------------------- */
 
+#include <configreader.h>
+
 #include "soccer.h"
 #include "evaluation.h"
+#include "intercept.h"
 
 Evaluation evaluation;
 
+// EvaluationPosition hands the threads this many points at a time.
+#define EVAL_CHUNK 8
+
+// Points by default with only the main thread to evaluate them, the
+// number before they were shared across the planning threads.
+#define EVAL_SERIAL_POINTS 10
+
+CR_DECLARE(EVAL_POSITION_POINTS);
+CR_DECLARE(OPPONENT_MODEL_SHOTS);
+CR_DECLARE(OPPONENT_MODEL_SHOT_BIAS);
+
+static void cr_setup_do()
+{
+  static bool cr_setup = false;
+
+  if (!cr_setup) {
+    CR_SETUP(tactic, EVAL_POSITION_POINTS, CR_INT);
+    CR_SETUP(strategy, OPPONENT_MODEL_SHOTS, CR_DOUBLE);
+    CR_SETUP(strategy, OPPONENT_MODEL_SHOT_BIAS, CR_DOUBLE);
+
+    cr_setup = true;
+  }
+}
+
 inline bool inside_bbox(vector2d bbox_min,vector2d bbox_max,
                         vector2d p,double radius)
 {
@@ -38,8 +65,76 @@ static double diffangle_pos(double a1, double a2) {
   return d;
 }
 
-static int double_compare(const void *a, const void *b) {
-  return (*((double *) a) > *((double *) b));
+// Angles for aim(), written without branches so that the loops over
+// obstacles can vectorize.  atan() on [-1,1] is a minimax polynomial,
+// good to 1e-5 radians, and fast_atan2() folds the other octants onto
+// it.
+static inline double fast_atan_unit(double z)
+{
+  double s = z*z;
+
+  return(z*(0.99997726 + s*(-0.33262347 + s*(0.19354346 +
+         s*(-0.11643287 + s*(0.05265332 + s*(-0.01172120)))))));
+}
+
+static inline double fast_atan2(double y, double x)
+{
+  double ax = fabs(x), ay = fabs(y);
+  double lo = (ax < ay)? ax : ay;
+  double hi = (ax < ay)? ay : ax;
+  double r = fast_atan_unit(lo / (hi + 1E-300));
+
+  r = (ay > ax)? M_PI_2 - r : r;
+  r = (x < 0)? M_PI - r : r;
+  return((y < 0)? -r : r);
+}
+
+// aim() considers at most every robot, each giving two ends of its
+// shadow, plus the ends of the target range.
+#define AIM_MAX_OBS  (MAX_TEAM_ROBOTS * 2)
+#define AIM_MAX_ENDS (AIM_MAX_OBS * 2 + 2)
+#define AIM_SORT_MAX 32 // power of two, at least AIM_MAX_ENDS
+
+// aim()'s working space, which lives on its stack so that aim() can
+// be called from any thread.
+struct aim_scratch {
+  // obstacles relative to the target, and their radii
+  double ox[AIM_MAX_OBS], oy[AIM_MAX_OBS], w[AIM_MAX_OBS];
+  // angles of their centers and edges from a_zero, and whether they
+  // are near enough to block
+  double a0[AIM_MAX_OBS], a1[AIM_MAX_OBS], a2[AIM_MAX_OBS];
+  bool near[AIM_MAX_OBS];
+
+  // angles of the shadows' ends, and +1/-1 as they leave/enter one
+  double d[AIM_SORT_MAX];
+  int i[AIM_SORT_MAX];
+};
+
+static inline void sort_exchange(double *d, int *k, int a, int b)
+{
+  double da = d[a], db = d[b];
+  int ka = k[a], kb = k[b];
+  bool swap = (db < da);
+
+  d[a] = swap? db : da;  d[b] = swap? da : db;
+  k[a] = swap? kb : ka;  k[b] = swap? ka : kb;
+}
+
+// Sorts the n ends by angle with Batcher's odd-even merge network,
+// padded to a power of two with ends past every angle.
+static void sort_ends(double *d, int *k, int n)
+{
+  int size, p, q, i, j;
+
+  for(size = 2; size < n; size *= 2);
+  for(i = n; i < size; i++) { d[i] = HUGE_VAL; k[i] = 0; }
+
+  for(p = 1; p < size; p *= 2)
+    for(q = p; q >= 1; q /= 2)
+      for(j = q % p; j + q < size; j += 2*q)
+	for(i = 0; i < q && i + j + q < size; i++)
+	  if ((i + j) / (2*p) == (i + j + q) / (2*p))
+	    sort_exchange(d, k, i + j, i + j + q);
 }
 
 bool Evaluation::aim(World &world, double time, 
@@ -48,8 +143,37 @@ bool Evaluation::aim(World &world, double time,
 		     vector2d pref_target_point, double pref_amount,
 		     vector2d &target_point, double &target_tolerance)
 {
-  static struct _double_int { double d; int i; } a[MAX_TEAM_ROBOTS * 4];
-  int n = 0, count = 0;
+  vector2d obs[AIM_MAX_OBS];
+  double radius[AIM_MAX_OBS];
+  int m = 0;
+
+  // Gather the obstacles.
+  for(int i=0; i<world.n_teammates; i++) {
+    if (!(obs_flags & OBS_TEAMMATE(i))) continue;
+
+    obs[m] = world.teammate_position(i, time);
+    radius[m++] = (world.teammate_type(i) == ROBOT_TYPE_DIFF ? 
+		   DIFFBOT_WIDTH_H : OMNIBOT_RADIUS);
+  }
+
+  for(int i=0; i<world.n_opponents; i++) {
+    if (!(obs_flags & OBS_OPPONENT(i))) continue;
+
+    obs[m] = world.opponent_position(i, time);
+    radius[m++] = ROBOT_DEF_WIDTH_H;
+  }
+
+  return aim(m, obs, radius, target, p2, p1, pref_target_point, pref_amount,
+	     target_point, target_tolerance);
+}
+
+bool Evaluation::aim(int n_obs, const vector2d *obs, const double *radius,
+		     vector2d target, vector2d p2, vector2d p1,
+		     vector2d pref_target_point, double pref_amount,
+		     vector2d &target_point, double &target_tolerance)
+{
+  aim_scratch s;
+  int n = 0, m = 0, count = 0;
   double a_zero;
   double a_end;
 
@@ -71,70 +195,57 @@ bool Evaluation::aim(World &world, double time,
   if (pref_target_angle - a_end > M_2PI - pref_target_angle)
     pref_target_angle -= M_2PI;
 
-  a[n].d = 0.0; a[n++].i = 0; 
-  a[n].d = a_end; a[n++].i = 0;
+  if (n_obs > AIM_MAX_OBS) n_obs = AIM_MAX_OBS;
 
-  for(int i=0; i<world.n_teammates; i++) {
-    if (!(obs_flags & OBS_TEAMMATE(i))) continue;
+  for(m=0; m<n_obs; m++) {
+    s.ox[m] = obs[m].x - target.x;
+    s.oy[m] = obs[m].y - target.y;
+    s.w[m] = radius[m];
+  }
 
-    double width = (world.teammate_type(i) == ROBOT_TYPE_DIFF ? 
-		    DIFFBOT_WIDTH_H : OMNIBOT_RADIUS);
-    vector2d obs = world.teammate_position(i, time) - target;
-    
-    vector2d obs_perp = obs.rotate(M_PI_2).norm() * width;
-    
-    double a0 = diffangle_pos(obs.angle(), a_zero);
-    double a1 = diffangle_pos((obs - obs_perp).angle(), a_zero);
-    double a2 = diffangle_pos((obs + obs_perp).angle(), a_zero);
-    
-    double maxdist;
-    
-    if (a0 < a_end)
-      maxdist = (a0 / a_end) * (r2.length() - r1.length()) + r1.length();
-    else {
-      if (a0 < (a_end + M_2PI) / 2.0) maxdist = r2.length();
-      else maxdist = r1.length();
-    }
-    
-    if (obs.length() - width > maxdist) continue;
-    
-    if (a1 < a_end) { a[n].d = a1; a[n++].i = 1; } 
-    if (a2 < a_end) { a[n].d = a2; a[n++].i = -1; }
-    if (a1 >= a_end && a2 < a_end) { count++; }
-    if (a1 >= a_end && a2 >= a_end && a1 > a2) { count++; }
+  // Each obstacle's center angle from a_zero, found in the frame
+  // rotated to a_zero, and its edges, which are off by atan(w/dist).
+  // Obstacles further than the target line along their center don't
+  // block.
+  double ca = cos(a_zero), sa = sin(a_zero);
+  double l1 = r1.length(), l2 = r2.length();
+
+  for(int j=0; j<m; j++) {
+    double x = s.ox[j]*ca + s.oy[j]*sa;
+    double y = s.oy[j]*ca - s.ox[j]*sa;
+    double dist = sqrt(x*x + y*y);
+    double a0 = fast_atan2(y, x);
+    double h = fast_atan2(s.w[j], dist);
+
+    a0 += (a0 < 0.0)? M_2PI : 0.0;
+    double a1 = a0 - h;
+    double a2 = a0 + h;
+    a1 += (a1 < 0.0)? M_2PI : 0.0;
+    a2 -= (a2 >= M_2PI)? M_2PI : 0.0;
+
+    double maxdist = (a0 < a_end)? (a0 / a_end) * (l2 - l1) + l1 :
+                     (a0 < (a_end + M_2PI) / 2.0)? l2 : l1;
+
+    s.a0[j] = a0; s.a1[j] = a1; s.a2[j] = a2;
+    s.near[j] = (dist - s.w[j] <= maxdist);
   }
 
-  double width = ROBOT_DEF_WIDTH_H;
+  s.d[n] = 0.0; s.i[n++] = 0; 
+  s.d[n] = a_end; s.i[n++] = 0;
 
-  for(int i=0; i<world.n_opponents; i++) {
-    if (!(obs_flags & OBS_OPPONENT(i))) continue;
+  for(int j=0; j<m; j++) {
+    if (!s.near[j]) continue;
 
-    vector2d obs = world.opponent_position(i, time) - target;
-    vector2d obs_perp = obs.rotate(M_PI_2).norm() * width;
-    
-    double a0 = diffangle_pos(obs.angle(), a_zero);
-    double a1 = diffangle_pos((obs - obs_perp).angle(), a_zero);
-    double a2 = diffangle_pos((obs + obs_perp).angle(), a_zero);
-    
-    double maxdist;
-    
-    if (a0 < a_end)
-      maxdist = (a0 / a_end) * (r2.length() - r1.length()) + r1.length();
-    else {
-      if (a0 < (a_end + M_2PI) / 2.0) maxdist = r2.length();
-      else maxdist = r1.length();
-    }
-    
-    if (obs.length() - width > maxdist) continue;
-    
-    if (a1 < a_end) { a[n].d = a1; a[n++].i = 1; } 
-    if (a2 < a_end) { a[n].d = a2; a[n++].i = -1; }
+    double a1 = s.a1[j], a2 = s.a2[j];
+
+    if (a1 < a_end) { s.d[n] = a1; s.i[n++] = 1; } 
+    if (a2 < a_end) { s.d[n] = a2; s.i[n++] = -1; }
     if (a1 >= a_end && a2 < a_end) { count++; }
     if (a1 >= a_end && a2 >= a_end && a1 > a2) { count++; }
   }
 
   // Sort the angle array.
-  qsort(a, n, sizeof(a[0]), &double_compare);
+  sort_ends(s.d, s.i, n);
 
   // Walk through the angle array finding the largest clear cone, and
   //  the closest clear cone to the preferred angle.
@@ -144,8 +255,8 @@ bool Evaluation::aim(World &world, double time,
   
   for(int i=1; i<n; i++) {
     if (!count) {
-      double tol = (a[i].d - a[i-1].d) / 2.0;
-      double ang = (a[i].d + a[i-1].d) / 2.0;
+      double tol = (s.d[i] - s.d[i-1]) / 2.0;
+      double ang = (s.d[i] + s.d[i-1]) / 2.0;
       double ang_diff = max(0.0, fabs(anglemod(ang - pref_target_angle))-tol);
 
       if (!found_one || tol > best_tol) {
@@ -159,7 +270,7 @@ bool Evaluation::aim(World &world, double time,
       found_one = true;
     }
     
-    count += a[i].i;
+    count += s.i[i];
   }
 
   // If there wasn't a clear angle we use the preferred angle and
@@ -194,12 +305,44 @@ bool Evaluation::aim(World &world, double time,
   return rv;
 }
 
+bool Evaluation::aim_shot(World &world, vector2d p,
+			  vector2d &target_point, double &target_tolerance)
+{
+  if (world.quality.shot(p, target_point, target_tolerance))
+    return (target_tolerance > 0.0);
+
+  return aim(world, world.now, p, world.their_goal_r, world.their_goal_l,
+	     OBS_OPPONENTS, target_point, target_tolerance);
+}
+
+bool Evaluation::shot_habit(World &world, 
+			    vector2d &pref_point, double &pref_amount)
+{
+  double y, spread;
+
+  cr_setup_do();
+
+  if (DVAR(OPPONENT_MODEL_SHOT_BIAS) <= 0.0) return false;
+  if (world.modeller.shot_count() < DVAR(OPPONENT_MODEL_SHOTS)) return false;
+  if (!world.modeller.shot_target(y, spread)) return false;
+
+  // shots spread evenly across the goal say nothing
+  double agree = 1.0 - spread / (GOAL_WIDTH / sqrt(12.0));
+  if (agree <= 0.0) return false;
+
+  pref_point = vector2d(world.our_goal_l.x, y);
+  pref_amount = DVAR(OPPONENT_MODEL_SHOT_BIAS) * agree;
+
+  return true;
+}
+
 bool Evaluation::defend_point(World &world, double time,
 			      vector2d point, 
 			      double distmin, double distmax, 
 			      double dist_off_ball,
 			      bool &intercept,
-			      vector2d &target, vector2d &velocity)
+			      vector2d &target, vector2d &velocity,
+			      int me)
 {
   double radius = (world.ball_position(time) - point).length() - dist_off_ball;
 
@@ -213,7 +356,7 @@ bool Evaluation::defend_point(World &world, double time,
   int rv[3]; 
 
   rv[0] = intercept && defend_point_intercept(world, time, point, radius,
-					      targets[0], variance[0]);
+					      targets[0], variance[0], me);
   intercept = rv[0];
 
   rv[1] = defend_point_static(world, time, point, radius,
@@ -259,7 +402,8 @@ bool Evaluation::defend_line(World &world, double time,
 			     bool &intercept,
 			     int obs_flags, 
 			     vector2d pref_point, double pref_amount,
-			     vector2d &target, vector2d &velocity)
+			     vector2d &target, vector2d &velocity,
+			     int me)
 {
   vector2d ball = world.ball_position(time);
   vector2d g = (g1 + g2) / 2.0;
@@ -270,7 +414,7 @@ bool Evaluation::defend_line(World &world, double time,
   // Special case of defending a single point. 
   if (g1 == g2) return defend_point(world, time, g1, 
 				    distmin, distmax, dist_off_ball, intercept,
-				    target, velocity);
+				    target, velocity, me);
 
   // First find the distance between min and max to play.
   //
@@ -299,7 +443,7 @@ bool Evaluation::defend_line(World &world, double time,
   int rv[3]; 
 
   rv[0] = intercept && defend_line_intercept(world, time, g1, g2, dist, 
-					     targets[0], variance[0]);
+					     targets[0], variance[0], me);
   intercept = rv[0];
 
   if (!obs_flags) {
@@ -494,30 +638,35 @@ bool Evaluation::defend_line_static(World &world, double time,
 //
 // (g1, g2) defines a line segment to be defended.
 //
-// We lookahead through the ball's trajectory to find where, if it at
-// all the ball crosses the goalie's line.  The covariance matrix is then
-// used to set the variance for this position.
+// We solve for where, if at all within the lookahead, the ball's
+// trajectory crosses the goalie's line (see ball_path).  If the ball
+// hits a robot first it won't get there, and if the robot me can't
+// get there before it does there's nothing to intercept.  The
+// covariance matrix is then used to set the variance for this
+// position.
 //
 
 #define P_DefendLookahead 1.0
-#define P_DefendLookstep  FRAME_PERIOD
 
 bool Evaluation::defend_line_intercept(World &world, double time,
 				       vector2d g1, vector2d g2, double dist,
-				       vector2d &target, double &variance)
+				       vector2d &target, double &variance,
+				       int me)
 {
   static double lookahead = P_DefendLookahead;
-  static double lookstep = P_DefendLookstep;
   static double radius = 90.0; // Should be a parameter
 
   vector2d gline = (g2 - g1);
   vector2d gline_1 = gline.norm();
   vector2d gperp = gline_1.rotate(M_PI_2);
-  vector2d ball = world.ball_position(time);
 
+  ball_path path;
+  path.set(world, time);
+
+  vector2d ball = path.start();
   int side = (ball - g1).dot(gperp) >= 0.0 ? 1 : -1;
   
-  if (world.ball_velocity(time).dot(gperp) * side >= 0.0)
+  if (path.velocity(0).dot(gperp) * side >= 0.0)
     return false;
 
   vector2d orig_g1 = g1, orig_g2 = g2;
@@ -532,48 +681,39 @@ bool Evaluation::defend_line_intercept(World &world, double time,
 		    orig_g1 + gperp * (side * (dist + radius)),
 		    orig_g2 + gperp * (side * (dist + radius)));
 
-  // Lookahead from now to lookahead.
-  for(double t = 0.0; t < lookahead; t += lookstep) {
-
-    if (t!=0) 
-      gui_debug_line(-1, GDBG_STRATEGY, 
-		     world.ball_position(time + t - lookstep), 
-		     world.ball_position(time + t));
+  // Where the ball's path crosses the line, if it does in time.
+  double t = path.time_to_line(g1, gperp);
+  if (t < 0.0 || t >= lookahead) return false;
 
-    vector2d b = world.ball_position(time + t);
-    vector2d v = world.ball_velocity(time + t); 
+  if (ball_collision_time(world, path, time, t) >= 0.0) return false;
 
-    if (v.dot(gperp) * side >= 0.0) return false;
+  vector2d b = path.position(t);
 
-    double d_to_line = fabs((b - g1).dot(gperp));
-    double t_to_line = d_to_line / fabs(v.dot(gperp));
+  gui_debug_line(-1, GDBG_STRATEGY, ball, b);
 
-    if (t_to_line > lookstep) continue;
+  double x = offset_along_line(g1, g2, b);
 
-    b += v * t_to_line;
+  Matrix c = world.ball_covariances(time + t);
+  Matrix m = Matrix(4,1); 
+  m.e(0,0) = gline_1.x;
+  m.e(1,0) = gline_1.y;
+  m.e(2,0) = m.e(3,0) = 0.0;
+  variance = (transpose(m) * c * m).e(0,0);
 
-    double x = offset_along_line(g1, g2, b);
-
-    Matrix c = world.ball_covariances(time + t);
-    Matrix m = Matrix(4,1); 
-    m.e(0,0) = gline_1.x;
-    m.e(1,0) = gline_1.y;
-    m.e(2,0) = m.e(3,0) = 0.0;
-    variance = (transpose(m) * c * m).e(0,0);
+  if (x < 0.0) {
+    x = 0;
+    variance = variance * exp(pow(x, 2.0) / variance);
+  } else if (x > gline.length()) {
+    x = gline.length();
+    variance = variance * exp(pow(gline.length() - x, 2.0) / variance);
+  }
 
-    if (x < 0.0) {
-      x = 0;
-      variance = variance * exp(pow(x, 2.0) / variance);
-    } else if (x > gline.length()) {
-      x = gline.length();
-      variance = variance * exp(pow(gline.length() - x, 2.0) / variance);
-    }
+  target = g1 + gline_1 * x;
 
-    target = g1 + gline_1 * x;
-    return true;
-  }
+  if (me >= 0 && teammate_motion_time(world, me, target, time) > t)
+    return false;
 
-  return false;
+  return true;
 }
 
 bool Evaluation::defend_point_static(World &world, double time,
@@ -595,10 +735,10 @@ bool Evaluation::defend_point_static(World &world, double time,
 
 bool Evaluation::defend_point_intercept(World &world, double time,
 					vector2d point, double radius,
-					vector2d &target, double &variance)
+					vector2d &target, double &variance,
+					int me)
 {
   static double lookahead = P_DefendLookahead;
-  static double lookstep = P_DefendLookstep;
 
   vector2d ball = world.ball_position(time);
   vector2d ball_vel = world.ball_velocity(time);
@@ -607,21 +747,28 @@ bool Evaluation::defend_point_intercept(World &world, double time,
       ball_vel.dot(point - ball) < 0.0 || 
       (ball - point).length() < radius) return false; 
 
-  // Lookahead from now to lookahead.
-  double closest_dist = (ball - point).length();
-  double closest_time = 0.0;
+  // When the ball reaches the radius, or else comes closest, within
+  // the lookahead.
+  ball_path path;
+  path.set(ball, ball_vel);
 
-  for(double t = 0.0; t < lookahead; t += lookstep) {
-    vector2d b = world.ball_position(time + t);
+  double closest_time = path.time_to_circle(point, radius);
+  bool reaches = (closest_time >= 0.0 && closest_time < lookahead);
 
-    if ((b - point).length() < closest_dist) {
-      closest_dist = (b - point).length();
-      closest_time = t;
-      target = point + (b - point).norm(radius);
+  if (!reaches) closest_time = path.closest_time(point, lookahead);
 
-      if (closest_dist < radius) break;
-    }
-  }
+  vector2d b = path.position(closest_time);
+  double closest_dist = reaches ? radius : (b - point).length();
+
+  target = point + (b - point).norm(radius);
+
+  // Not if it hits a robot on the way, or we can't get there first.
+  if (ball_collision_time(world, path, time, closest_time) >= 0.0)
+    return false;
+
+  if (me >= 0 &&
+      teammate_motion_time(world, me, target, time) > closest_time)
+    return false;
 
   // Compute variance
   Matrix c = world.ball_covariances(time + closest_time);
@@ -732,3 +879,102 @@ vector2d Evaluation::findOpenPositionAndYield(World &world, vector2d p,
 
   return p;
 }
+
+void EvaluationPosition::set(TRegion _region,
+			     EvalFn _eval, 
+			     double _pref_amount,
+			     int _n_points)
+{
+  cr_setup_do();
+
+  default_points = (_n_points <= 0);
+  if (default_points) _n_points = IVAR(EVAL_POSITION_POINTS);
+
+  region = _region;
+  eval = _eval; n_points = _n_points;
+  pref_amount = _pref_amount;
+
+  obs_flags = 0;
+
+  points.clear();
+  angles.clear();
+  weights.clear();
+  new_points.clear();
+  best = -1;
+  last_updated = 0;
+  eval_world = NULL;
+
+  // so update() doesn't grow them
+  points.reserve(n_points + 1);
+  angles.reserve(n_points + 1);
+  weights.reserve(n_points + 1);
+}
+
+void EvaluationPosition::evalJob(void *arg, int job)
+{
+  EvaluationPosition *e = (EvaluationPosition *) arg;
+  uint end = (job + 1) * EVAL_CHUNK;
+
+  if (end > e->points.size()) end = e->points.size();
+
+  for(uint i = job * EVAL_CHUNK; i < end; i++)
+    e->weights[i] = (e->eval)(*e->eval_world, e->points[i], e->obs_flags,
+			      e->angles[i]);
+}
+
+void EvaluationPosition::update(World &world, int _obs_flags)
+{
+  // Only update if world has changed.
+  if (world.time <= last_updated) return;
+  last_updated = world.time;
+
+  obs_flags = _obs_flags;
+
+  // The candidates only live until they're copied into points, so
+  // they're built in this frame's scratch memory.
+  frame_vector<vector2d> cand;
+  cand.reserve(new_points.size() + n_points + 1);
+
+  // Check the new points to make sure their within the region.
+  // Passed here by addPoint().
+  for(uint i = 0; i<new_points.size(); i++)
+    if (region.inRegion(world, new_points[i]))
+      cand.push_back(new_points[i]);
+  new_points.clear();
+
+  // Add previous best point (or center).
+  if (!points.empty()) {
+    cand.push_back(points[best]); best = cand.size() - 1; 
+  } else {
+    cand.push_back(region.center(world)); best = -1;
+  }
+
+  // Pick new points.
+  uint want = n_points;
+  if (default_points && world.planThreads() <= 1 && want > EVAL_SERIAL_POINTS)
+    want = EVAL_SERIAL_POINTS;
+
+  while(cand.size() < want)
+    cand.push_back(pointFromDistribution(world));
+
+  points.assign(cand.begin(), cand.end());
+
+  // Evaluate points, each thread writing its own slots.
+  uint n = points.size();
+
+  weights.resize(n);
+  angles.resize(n);
+
+  eval_world = &world;
+  world.runParallel(evalJob, this, (n + EVAL_CHUNK - 1) / EVAL_CHUNK);
+  eval_world = NULL;
+
+  int best_i = 0;
+
+  for(uint i=1; i<n; i++)
+    if (weights[i] > weights[best_i]) best_i = i;
+
+  if (best < 0 || weights[best_i] > weights[best] + pref_amount) {
+    best = best_i;
+  }
+}
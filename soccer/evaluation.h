@@ -25,6 +25,7 @@
 
 #include "world.h"
 #include "tactic.h"
+#include "frame_arena.h"
 
 class Evaluation {
 public:
@@ -58,6 +59,34 @@ public:
 	       target_point, target_tolerance);
   }
 
+  // As above, with the obstacles given as n_obs circles (at most two
+  // teams' worth) instead of taken from the world.  It uses nothing
+  // else, so it can be called from any thread.
+  bool aim(int n_obs, const vector2d *obs, const double *radius,
+	   vector2d target, vector2d r2, vector2d r1,
+	   vector2d pref_target_point, double pref_amount,
+	   vector2d &target_point, double &target_tolerance);
+
+  // aim_shot()
+  //
+  // aim() at their goal from p past the opponents, now.  The answer
+  // comes from world.quality's grid when it's on.
+  //
+
+  bool aim_shot(World &world, vector2d p,
+		vector2d &target_point, double &target_tolerance);
+
+  // shot_habit()
+  //
+  // Where across our goal the opponents' shots have tended to go, from
+  // world.modeller, as a preference for aim() when defending it.  The
+  // amount is up to OPPONENT_MODEL_SHOT_BIAS (strategy.cfg), less the
+  // more widely the shots are spread.  False until there have been
+  // OPPONENT_MODEL_SHOTS of them, or if the bias is 0.
+  //
+
+  bool shot_habit(World &world, vector2d &pref_point, double &pref_amount);
+
   // defend_line()
   // defend_point()
   // defend_on_line()
@@ -83,7 +112,8 @@ public:
   //
   // The intercept field specifies whether a moving ball should be
   // intercepted.  If true after the call it means the robot is actively
-  // trying to intercept the ball.
+  // trying to intercept the ball.  Given the robot me, it only tries
+  // where it can get before the ball does (see intercept.h).
   //
 
   bool defend_line(World &world, double time, 
@@ -92,22 +122,22 @@ public:
 		   bool &intercept,
 		   int obs_flags, 
 		   vector2d pref_point, double pref_amount,
-		   vector2d &target, vector2d &velocity);
+		   vector2d &target, vector2d &velocity, int me = -1);
 
   bool defend_line(World &world, double time, 
 		   vector2d g1, vector2d g2, 
 		   double distmin, double distmax, double dist_off_ball,
 		   bool &intercept,
-		   vector2d &target, vector2d &velocity) {
+		   vector2d &target, vector2d &velocity, int me = -1) {
     return defend_line(world, time, g1, g2, distmin, distmax, dist_off_ball,
-		       intercept, 0, vector2d(), 0.0, target, velocity);
+		       intercept, 0, vector2d(), 0.0, target, velocity, me);
   }
 
   bool defend_point(World &world, double time,
 		    vector2d point, 
 		    double distmin, double distmax, double dist_off_ball,
 		    bool &intercept,
-		    vector2d &target, vector2d &velocity);
+		    vector2d &target, vector2d &velocity, int me = -1);
 
   bool defend_on_line(World &world, double time,
 		      vector2d p1, vector2d p2,
@@ -121,7 +151,7 @@ private:
 
   bool defend_line_intercept(World &world, double time,
 			     vector2d g1, vector2d g2, double dist,
-			     vector2d &target, double &variance);
+			     vector2d &target, double &variance, int me = -1);
 
   bool defend_point_static(World &world, double time,
 			   vector2d point, double radius,
@@ -129,7 +159,7 @@ private:
 
   bool defend_point_intercept(World &world, double time,
 			      vector2d point, double radius,
-			      vector2d &target, double &variance);
+			      vector2d &target, double &variance, int me = -1);
 
 public:
   vector2d farthest(World &world, double time, 
@@ -147,6 +177,9 @@ public:
 
 extern Evaluation evaluation;
 
+// Candidates are evaluated in parallel on the world's planning
+// threads, so EvalFn must only read the world's positions at its
+// present and otherwise keep to its arguments.
 class EvaluationPosition {
 public:
   typedef double (*EvalFn)(World &world, const vector2d p, 
@@ -162,8 +195,9 @@ private:
 
   double last_updated;
 
-  // Evaluated Points
+  // Evaluated Points, all sized for n_points + 1 up front
   uint n_points;
+  bool default_points; // n_points is EVAL_POSITION_POINTS
   vector<vector2d> points;
   vector<double> angles;
   vector<double> weights;
@@ -173,82 +207,32 @@ private:
   int best;
   double pref_amount;
 
+  // the world being evaluated in, for the threads
+  World *eval_world;
+
   vector2d pointFromDistribution(World &w) {
     return region.sample(w);
   }
 
+  static void evalJob(void *arg, int i);
+
 public:
-  EvaluationPosition() { }
+  EvaluationPosition() { n_points = 0; default_points = false; best = -1; }
   EvaluationPosition(TRegion _region,
 		     EvalFn _eval, 
 		     double _pref_amount = 0,
-		     int _n_points = 10) {
-    set(_region, _eval, _pref_amount, n_points);
+		     int _n_points = 0) {
+    set(_region, _eval, _pref_amount, _n_points);
   }
 
+  // With _n_points 0 there are EVAL_POSITION_POINTS (tactic.cfg), or
+  // EVAL_SERIAL_POINTS with no planning threads to share them.
   void set(TRegion _region,
 	   EvalFn _eval, 
 	   double _pref_amount = 0,
-	   int _n_points = 10) {
-    region = _region;
-    eval = _eval; n_points = _n_points;
-    pref_amount = _pref_amount;
+	   int _n_points = 0);
 
-    obs_flags = 0;
-
-    points.clear();
-    weights.clear();
-    best = -1;
-    last_updated = 0;
-  }
-
-  void update(World &world, int _obs_flags) {
-    // Only update if world has changed.
-    if (world.time <= last_updated) return;
-    last_updated = world.time;
-
-    obs_flags = _obs_flags;
-
-    // Check the new points to make sure their within the region.
-    // Passed here by addPoint().
-    for(uint i = 0; i<new_points.size(); i++)
-      if (!region.inRegion(world, new_points[i])) {
-	new_points.erase(new_points.begin() + i);
-	i--;
-      }
-
-    // Add previous best point (or center).
-    if (!points.empty()) {
-      new_points.push_back(points[best]); best = new_points.size() - 1; 
-    } else {
-      new_points.push_back(region.center(world)); best = -1;
-    }
-
-    // Pick new points.
-    while(new_points.size() < n_points)
-      new_points.push_back(pointFromDistribution(world));
-
-    points = new_points;
-    new_points.clear();
-      
-    // Evaluate points.
-    int best_i = -1;
-
-    weights.clear(); angles.clear();
-    for(uint i=0; i<points.size(); i++) {
-      double a;
-
-      weights.push_back((eval)(world, points[i], obs_flags, a));
-      angles.push_back(a);
-
-      if (best_i < 0 || weights[i] > weights[best_i]) best_i = i;
-    }
-
-    if (best < 0 || weights[best_i] > weights[best] + pref_amount) {
-      best = best_i;
-    }
-
-  }
+  void update(World &world, int _obs_flags);
 
   void addPoint(vector2d p) {
     for(uint i=0; i<new_points.size(); i++)
@@ -0,0 +1,166 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <new>
+
+#include "frame_arena.h"
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_BLOCK 65536
+
+frame_arena frame_mem;
+
+//====================================================================//
+//    Heap allocation count
+//====================================================================//
+
+// The soccer program is linked with malloc(), calloc() and realloc()
+// wrapped (see the Makefile), so every heap allocation made by our own
+// code and libutils comes through here, including operator new and the
+// Kalman filters' matrices.  That is how the main loop can tell
+// whether a frame touched the heap.
+
+static long heap_allocs = 0;
+
+long heap_alloc_count()
+{
+  return(heap_allocs);
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n,size_t size);
+void *__real_realloc(void *p,size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  __sync_fetch_and_add(&heap_allocs,1);
+  return(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t n,size_t size)
+{
+  __sync_fetch_and_add(&heap_allocs,1);
+  return(__real_calloc(n,size));
+}
+
+void *__wrap_realloc(void *p,size_t size)
+{
+  __sync_fetch_and_add(&heap_allocs,1);
+  return(__real_realloc(p,size));
+}
+}
+
+// The library's operator new is outside the wrapping, so it's
+// replaced with one that calls (the wrapped) malloc().
+void *operator new(size_t size)
+{
+  void *p = malloc(size? size : 1);
+  if(!p) throw std::bad_alloc();
+
+  return(p);
+}
+
+void *operator new[](size_t size)
+{
+  return(operator new(size));
+}
+
+void operator delete(void *p) throw()
+{
+  free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+  free(p);
+}
+
+//====================================================================//
+//    Frame arena
+//====================================================================//
+
+frame_arena::~frame_arena()
+{
+  block *b;
+
+  while((b = blocks) != NULL){
+    blocks = b->next;
+    free(b);
+  }
+}
+
+void frame_arena::add_block(size_t size)
+{
+  block *b;
+
+  if(size < ARENA_MIN_BLOCK) size = ARENA_MIN_BLOCK;
+
+  b = (block*)malloc(sizeof(block) + ARENA_ALIGN + size);
+  if(!b){
+    fprintf(stderr,"frame_arena: Out of memory (%ld bytes).\n",(long)size);
+    throw std::bad_alloc();
+  }
+  b->next = blocks;
+  b->size = size;
+  blocks = b;
+  total += size;
+
+  cur = (char*)(b + 1);
+  cur += (ARENA_ALIGN - ((size_t)cur % ARENA_ALIGN)) % ARENA_ALIGN;
+  end = cur + size;
+}
+
+void *frame_arena::alloc(size_t size)
+{
+  void *p;
+
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  if(cur + size > end) add_block(size);
+
+  p = cur;
+  cur += size;
+  used += size;
+
+  return(p);
+}
+
+void frame_arena::reset()
+{
+  block *b;
+  size_t size;
+
+  // Grown this frame, so start again with one block that would have
+  // held it all.
+  if(blocks && blocks->next){
+    size = total;
+    while((b = blocks) != NULL){
+      blocks = b->next;
+      free(b);
+    }
+    total = 0;
+    add_block(size);
+  }
+
+  if(blocks){
+    cur = (char*)(blocks + 1);
+    cur += (ARENA_ALIGN - ((size_t)cur % ARENA_ALIGN)) % ARENA_ALIGN;
+  }
+  used = 0;
+}
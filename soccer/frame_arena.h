@@ -0,0 +1,106 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// Scratch memory for a single frame.  Allocation bumps a pointer and
+// nothing is freed until reset(), which the main loop calls at the top
+// of every frame.  If a frame runs out of the block, more are added,
+// and the next reset() replaces them all with one block big enough for
+// that frame, so once the busiest frame has been seen the arena stops
+// touching the heap.  frame_mem is for the main thread only.
+
+#ifndef __FRAME_ARENA_H__
+#define __FRAME_ARENA_H__
+
+#include <stddef.h>
+
+#include <new>
+#include <vector>
+
+class frame_arena{
+  struct block{
+    block *next;
+    size_t size;
+  };
+
+  block *blocks; // the current block first
+  char *cur,*end;
+  size_t used;   // bytes handed out since reset()
+  size_t total;  // bytes in all blocks
+
+  void add_block(size_t size);
+public:
+  frame_arena() {blocks=NULL; cur=end=NULL; used=total=0;}
+  ~frame_arena();
+
+  void *alloc(size_t size);
+  void reset();
+
+  size_t bytes_used() {return(used);}
+  size_t capacity()   {return(total);}
+};
+
+extern frame_arena frame_mem;
+
+// Number of heap allocations so far in this program, from any thread:
+// operator new, and malloc(), calloc() and realloc() from our own code
+// and libutils.
+long heap_alloc_count();
+
+// An STL allocator on frame_mem.  Containers using it must not outlive
+// the frame they were filled in.
+template <class T>
+class frame_allocator{
+public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <class U> struct rebind {typedef frame_allocator<U> other;};
+
+  frame_allocator() {}
+  frame_allocator(const frame_allocator &) {}
+  template <class U> frame_allocator(const frame_allocator<U> &) {}
+
+  pointer address(reference x) const {return(&x);}
+  const_pointer address(const_reference x) const {return(&x);}
+
+  pointer allocate(size_type n,const void * = 0)
+    {return((pointer)frame_mem.alloc(n * sizeof(T)));}
+  void deallocate(pointer,size_type) {}
+
+  size_type max_size() const {return(((size_t)-1) / sizeof(T));}
+
+  void construct(pointer p,const T &v) {new((void*)p) T(v);}
+  void destroy(pointer p) {p->~T();}
+};
+
+template <class T,class U>
+inline bool operator==(const frame_allocator<T> &,const frame_allocator<U> &)
+{return(true);}
+
+template <class T,class U>
+inline bool operator!=(const frame_allocator<T> &,const frame_allocator<U> &)
+{return(false);}
+
+// A vector for scratch data within a frame.
+template <class T>
+class frame_vector : public std::vector<T,frame_allocator<T> > {};
+
+#endif /*__FRAME_ARENA_H__*/
@@ -51,6 +51,13 @@ static bool cr_setup_robot = false;
 CR_DECLARE(NAV_OUR_OBSTACLE_RADIUS);
 CR_DECLARE(NAV_THEIR_OBSTACLE_RADIUS);
 CR_DECLARE(NAV_THEIR_GOALIE_OBSTACLE_RADIUS);
+CR_DECLARE(PLAN_KINO_OMNI);
+CR_DECLARE(PLAN_KINO_LOOKAHEAD);
+CR_DECLARE(PLAN_CAPTURE);
+CR_DECLARE(NAV_SWEEP);
+CR_DECLARE(NAV_SWEEP_HORIZON);
+CR_DECLARE(NAV_TTC_MIN_SPEED);
+CR_DECLARE(PLAN_CAPTURE_FILE);
 
 float Robot::motion_time_1d(float dx,float vel0,float vel1,
                             float max_vel,float max_accel,
@@ -381,13 +388,22 @@ Robot::Trajectory Robot::goto_point_omni(World &world, int me,
 
   double ang_a,factor_a;
   double time_a, time;
+  double speed,s;
 
   int type = the_type;
   if (type == GotoPointMoveForw) type = GotoPointMove;
 
+  // no faster than we could stop in before running into someone
+  speed = VDVAR(OMNI_MAX_SPEED)[type];
+  if (nav_ttc >= 0) {
+    s = VDVAR(OMNI_MAX_ACCEL)[type] * nav_ttc;
+    if (s < DVAR(NAV_TTC_MIN_SPEED)) s = DVAR(NAV_TTC_MIN_SPEED);
+    if (s < speed) speed = s;
+  }
+
   compute_motion_2d(x, v, target_vel, 
 		    VDVAR(OMNI_MAX_ACCEL)[type], 
-		    VDVAR(OMNI_MAX_SPEED)[type],
+		    speed,
 		    DVAR(OMNI_ACCEL_FACTOR),
 		    a, time);
 
@@ -407,8 +423,8 @@ Robot::Trajectory Robot::goto_point_omni(World &world, int me,
 
   v = v.rotate(-world.teammate_direction(me));
 
-  if (v.length() > VDVAR(OMNI_MAX_SPEED)[type]) 
-    v = v.norm() * VDVAR(OMNI_MAX_SPEED)[type];
+  if (v.length() > speed) 
+    v = v.norm() * speed;
   ang_v = bound(ang_v, 
 		-VDVAR(OMNI_MAX_ANG_VEL)[type], 
 		VDVAR(OMNI_MAX_ANG_VEL)[type]);
@@ -532,6 +548,37 @@ Robot::Trajectory Robot::goto_point_diff(World &world, int me,
   return Trajectory(v.x, 0.0, ang_v, time);
 }
 
+// Appends every PLAN_CAPTURE'th planning problem to PLAN_CAPTURE_FILE,
+// for replaying with plan_bench.
+static void capture_plan(int me,obstacles &obs,
+                         ::state initial,vector2f vel,::state goal)
+{
+  static FILE *out = NULL;
+  static int count = 0;
+  plan_scenario s;
+
+  if(++count % IVAR(PLAN_CAPTURE) != 0) return;
+
+  if(!out){
+    out = fopen(SVAR(PLAN_CAPTURE_FILE),"a");
+    if(!out){
+      fprintf(stderr,"nav_to_point: Cannot open %s.\n",
+              SVAR(PLAN_CAPTURE_FILE));
+      IVAR(PLAN_CAPTURE) = 0;
+      return;
+    }
+  }
+
+  s.robot = me;
+  s.initial = initial;
+  s.vel = vel;
+  s.goal = goal;
+  s.mask = 1;
+  s.obs = obs;
+  s.write(out);
+  fflush(out);
+}
+
 Robot::Trajectory Robot::nav_to_point(World &world, int me,
 				      vector2d target_pos, vector2d target_vel,
 				      double target_angle,int obs_flags,
@@ -541,18 +588,29 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
   ::state initial,target,goal;
   vector2d rp,rv,p,v;
   double rs,s; // relative speeds
-  vector2d q,qr,obs_vel;
+  vector2d q;
   vector2d ball,ball_vel;
-  double a,t,tmax,qrl,rad;
+  double a,t,tmax,rad;
   double out_x,out_y;
   int obs_id;
   int goalie_id;
-  int i;
+  int i,k;
+  bool kino,sweep;
 
-  if (!cr_setup_diff) {
+  if (!cr_setup_robot) {
     CR_SETUP(robot, NAV_THEIR_OBSTACLE_RADIUS, CR_DOUBLE);
     CR_SETUP(robot, NAV_OUR_OBSTACLE_RADIUS, CR_DOUBLE);
     CR_SETUP(robot, NAV_THEIR_GOALIE_OBSTACLE_RADIUS, CR_DOUBLE);
+    CR_SETUP(robot, PLAN_KINO_OMNI, CR_INT);
+    CR_SETUP(robot, PLAN_KINO_LOOKAHEAD, CR_DOUBLE);
+    CR_SETUP(robot, PLAN_CAPTURE, CR_INT);
+    CR_SETUP(robot, PLAN_CAPTURE_FILE, CR_STRING);
+    CR_SETUP(robot, NAV_SWEEP, CR_INT);
+    CR_SETUP(robot, NAV_SWEEP_HORIZON, CR_DOUBLE);
+    CR_SETUP(robot, NAV_TTC_MIN_SPEED, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_ACCEL, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_SPEED, CR_DOUBLE);
+    CR_SETUP(motion, DIFF_MAX_SPEED, CR_DOUBLE);
 
     cr_setup_robot = true;
   }
@@ -570,6 +628,13 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
   ball     = world.ball_position();
   ball_vel = world.ball_velocity();
 
+  // The space-time planner sees robots moving, so they are added where
+  // they are now rather than where we guess we'd meet them.
+  kino = IVAR(PLAN_KINO_OMNI) && world.teammate_type(me) == ROBOT_TYPE_OMNI;
+  // So does path_planner when sweeping, checking robots over time.
+  sweep = IVAR(NAV_SWEEP) && !kino;
+  k = (type == GotoPointMoveForw)? GotoPointMove : type;
+
   // set up teammates as obstacles
   for(i=0; i<world.n_teammates; i++){
     if(i!=me && (OBS_TEAMMATE(i) & obs_flags)){
@@ -584,6 +649,7 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
 
       // if we can get to our target, or its far away, don't bother
       t = min3(t,tmax,4.0);
+      if(kino || sweep) t = 0;
 
       /*
       printf("  s=(%7.2f,%7.2f) t=%5.4f tmax=%5.4f d=%7.2f\n",
@@ -612,6 +678,7 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
 
         // if we can get to our target, or its far away, don't bother
         t = min3(t,tmax,4.0);
+        if(kino || sweep) t = 0;
 
         q = p + v*t;
 	rad = (i != goalie_id)? DVAR(NAV_THEIR_GOALIE_OBSTACLE_RADIUS) :
@@ -629,33 +696,10 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
     }
   }
 
-  // walls
-  if(obs_flags & OBS_WALLS){
-    obs.add_half_plane(-FIELD_LENGTH_H-GOAL_DEPTH, 0, 1, 0,1);
-    obs.add_half_plane( FIELD_LENGTH_H+GOAL_DEPTH, 0,-1, 0,1);
-    obs.add_half_plane( 0,-FIELD_WIDTH_H, 0, 1,1);
-    obs.add_half_plane( 0, FIELD_WIDTH_H, 0,-1,1);
-
-    obs.add_rectangle(-FIELD_LENGTH_H-GOAL_DEPTH,
-                       (FIELD_WIDTH_H+GOAL_WIDTH_H)/2,
-                      GOAL_DEPTH,FIELD_WIDTH_H-GOAL_WIDTH_H,1);
-    obs.add_rectangle(-FIELD_LENGTH_H-GOAL_DEPTH,
-                      -(FIELD_WIDTH_H+GOAL_WIDTH_H)/2,
-                      GOAL_DEPTH,FIELD_WIDTH_H-GOAL_WIDTH_H,1);
-
-    obs.add_rectangle( FIELD_LENGTH_H+GOAL_DEPTH,
-                       (FIELD_WIDTH_H+GOAL_WIDTH_H)/2,
-                      GOAL_DEPTH,FIELD_WIDTH_H-GOAL_WIDTH_H,1);
-    obs.add_rectangle( FIELD_LENGTH_H+GOAL_DEPTH,
-                      -(FIELD_WIDTH_H+GOAL_WIDTH_H)/2,
-                      GOAL_DEPTH,FIELD_WIDTH_H-GOAL_WIDTH_H,1);
-  }
+  // walls, goals and defense zones, which never move
+  obs.add_static(world.static_field,obs_flags,1);
 
-  // defense zones
   if(obs_flags & OBS_OUR_DZONE){
-    obs.add_rectangle(-FIELD_LENGTH_H-DEFENSE_DEPTH,0,
-                      DEFENSE_DEPTH*4,DEFENSE_WIDTH,1);
-
     // make 100% sure we're not going into defense zone
     out_x = (-FIELD_LENGTH_H+DEFENSE_DEPTH+100) - target_pos.x;
     out_y = (DEFENSE_WIDTH_H+100) - fabs(target_pos.y);
@@ -670,11 +714,6 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
     }
   }
 
-  if(obs_flags & OBS_THEIR_DZONE){
-    obs.add_rectangle( FIELD_LENGTH_H+DEFENSE_DEPTH,0,
-                       DEFENSE_DEPTH*4,DEFENSE_WIDTH,1);
-  }
-
   // ball
   if(obs_flags & OBS_BALL){
     t = bound(Vector::distance(ball,rp)-180,30,60);
@@ -682,23 +721,85 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
   }
   obs.set_mask(1);
 
+  if(sweep){
+    s = (world.teammate_type(me) == ROBOT_TYPE_OMNI)?
+        VDVAR(OMNI_MAX_SPEED)[k] : VDVAR(DIFF_MAX_SPEED)[k];
+    obs.set_sweep(s,DVAR(NAV_SWEEP_HORIZON));
+  }
+
   // set initial state
   p = world.teammate_position(me);
   v = world.teammate_velocity(me);
   a = world.teammate_direction(me);
   initial.pos = vdtof(p);
+  initial.t = 0;
   // initial.vel = vdtof(v);
   goal.pos = vdtof(target_pos);
   // goal.vel = vdtof(target_vel);
 
+  if(IVAR(PLAN_CAPTURE) > 0) capture_plan(me,obs,initial,vdtof(rv),goal);
+
   // plan
+  if(kino && world.plansDeferred()){
+    world.path[me].request_kino(obs,1,initial,vdtof(rv),goal,
+                                VDVAR(OMNI_MAX_ACCEL)[k],
+                                VDVAR(OMNI_MAX_SPEED)[k],
+                                DVAR(PLAN_KINO_LOOKAHEAD));
+  }else if(world.plansDeferred()){
+    world.path[me].request(obs,1,initial,goal);
+  }
+
+  if(world.plansDeferred()){
+
+    nav_pending.active = true;
+    nav_pending.target_pos = target_pos;
+    nav_pending.target_vel = target_vel;
+    nav_pending.target_angle = target_angle;
+    nav_pending.type = type;
+
+    return Trajectory(0.0, 0.0, 0.0);
+  }
+
   obs_id = -1;
-  target = world.path[me].plan(&obs,1,initial,goal,obs_id);
+  if(kino){
+    target = world.path[me].plan_kino(&obs,1,initial,vdtof(rv),goal,
+                                      VDVAR(OMNI_MAX_ACCEL)[k],
+                                      VDVAR(OMNI_MAX_SPEED)[k],
+                                      DVAR(PLAN_KINO_LOOKAHEAD),
+                                      world.planning.deadline(me));
+  }else{
+    target = world.path[me].plan(&obs,1,initial,goal,obs_id,
+                                 world.planning.deadline(me));
+  }
+  world.planning.finished(me,world.path[me]);
 
-  if(false){
-    printf("  Init(%f,%f)  Goal(%f,%f)  Target(%f,%f)\n",
-           V2COMP(initial.pos),V2COMP(goal.pos),V2COMP(target.pos));
-    if(target.pos.length() < 10) exit(1);
+  return nav_from_plan(world, me, obs, target, obs_id,
+                       target_pos, target_vel, target_angle, type);
+}
+
+Robot::Trajectory Robot::nav_from_plan(World &world, int me,
+                                       obstacles &obs, ::state target,
+                                       int obs_id,
+                                       vector2d target_pos,
+                                       vector2d target_vel,
+                                       double target_angle,
+                                       GotoPointType type)
+{
+  vector2d p,v,q,qr,obs_vel;
+  double s,qrl;
+  Trajectory t;
+
+  p = world.teammate_position(me);
+
+  // space-time plans give the velocity to arrive with
+  if(world.path[me].last_mode == PLAN_KINO){
+    q = vftod(target.pos);
+    if(Vector::distance(q,target_pos) > 1){
+      v = vftod(world.path[me].result_vel);
+    }else{
+      v = target_vel;
+    }
+    return goto_point(world, me, q, v, target_angle, type);
   }
 
   q   = vftod(target.pos);
@@ -718,7 +819,11 @@ Robot::Trajectory Robot::nav_to_point(World &world, int me,
     v = target_vel;
   }
 
-  return goto_point(world, me, q, v, target_angle, type);
+  nav_ttc = world.path[me].last_ttc;
+  t = goto_point(world, me, q, v, target_angle, type);
+  nav_ttc = -1;
+
+  return(t);
 }
 
 // 1400.0, 2000.0, 12.0, 12.0
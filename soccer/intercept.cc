@@ -0,0 +1,303 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include <configreader.h>
+
+#include "geometry.h"
+#include "constants.h"
+
+#include "world.h"
+#include "robot.h"
+#include "obstacle.h"
+#include "intercept.h"
+
+// intercept_ball() looks for the first time a robot can make it in
+// this many steps along the ball's path, then bisects that step.
+#define INTERCEPT_STEPS 20
+#define INTERCEPT_ITERATIONS 10
+
+static bool cr_setup = false;
+CR_DECLARE(BALL_FRICTION);
+CR_DECLARE(BALL_TEAMMATE_COLLISION_RADIUS);
+CR_DECLARE(BALL_OPPONENT_COLLISION_RADIUS);
+CR_DECLARE(OMNI_MAX_ACCEL);
+CR_DECLARE(OMNI_MAX_SPEED);
+CR_DECLARE(DIFF_MAX_ACCEL);
+CR_DECLARE(DIFF_MAX_SPEED);
+
+static void cr_setup_do()
+{
+  if (!cr_setup) {
+    CR_SETUP(tracker, BALL_FRICTION, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_TEAMMATE_COLLISION_RADIUS, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_OPPONENT_COLLISION_RADIUS, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_ACCEL, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_SPEED, CR_DOUBLE);
+    CR_SETUP(motion, DIFF_MAX_ACCEL, CR_DOUBLE);
+    CR_SETUP(motion, DIFF_MAX_SPEED, CR_DOUBLE);
+
+    cr_setup = true;
+  }
+}
+
+//====================================================================//
+//  Ball Path
+//====================================================================//
+
+void ball_path::set(vector2d p,vector2d v)
+{
+  cr_setup_do();
+
+  pos = p;
+  speed = v.length();
+  dir = (speed > 0.0)? v / speed : vector2d(1,0);
+  decel = DVAR(BALL_FRICTION) * GRAVITY;
+
+  if (decel > 0.0) stop_time = speed / decel;
+  else stop_time = (speed > 0.0)? HUGE_VAL : 0.0;
+}
+
+void ball_path::set(World &world,double time)
+{
+  set(world.ball_position(time),world.ball_velocity(time));
+}
+
+double ball_path::distance(double t)
+{
+  if (t > stop_time) t = stop_time;
+  if (t < 0.0) t = 0.0;
+
+  return(speed*t - 0.5*decel*t*t);
+}
+
+vector2d ball_path::position(double t)
+{
+  return(pos + dir*distance(t));
+}
+
+vector2d ball_path::velocity(double t)
+{
+  if (t >= stop_time) return(vector2d(0,0));
+  if (t < 0.0) t = 0.0;
+
+  return(dir * (speed - decel*t));
+}
+
+double ball_path::time_at(double s)
+{
+  if (s <= 0.0) return(0.0);
+
+  double disc = speed*speed - 2*decel*s;
+  if (disc < 0.0 || speed <= 0.0) return(-1);
+
+  // the smaller root of s = speed*t - decel*t^2/2, written to keep
+  // its precision as decel goes to 0
+  return(2*s / (speed + sqrt(disc)));
+}
+
+double ball_path::time_to_line(vector2d p,vector2d n)
+{
+  double d = (p - pos).dot(n);
+  double c = dir.dot(n);
+
+  if (d == 0.0) return(0.0);
+  if (c*d <= 0.0 || speed <= 0.0) return(-1);
+
+  return(time_at(d / c));
+}
+
+double ball_path::time_to_circle(vector2d p,double r)
+{
+  vector2d w = p - pos;
+
+  if (w.sqlength() <= r*r) return(0.0);
+
+  double along = w.dot(dir);
+  double off = w.sqlength() - along*along;
+
+  if (off > r*r || along < 0.0 || speed <= 0.0) return(-1);
+
+  return(time_at(along - sqrt(r*r - off)));
+}
+
+double ball_path::closest_time(vector2d p,double horizon)
+{
+  double end = (horizon < stop_time)? horizon : stop_time;
+  double s = (p - pos).dot(dir);
+
+  if (s <= 0.0 || speed <= 0.0) return(0.0);
+  if (s >= distance(end)) return(end);
+
+  double t = time_at(s);
+  return((t < 0.0)? end : t);
+}
+
+//====================================================================//
+//  Collisions
+//====================================================================//
+
+// Adds a robot as a circle the ball's center can't enter, unless the
+// ball is already inside it and moving away, as off a kicker.  The
+// swept test grows circles by ROBOT_RADIUS, so that comes off here.
+// Returns true if the ball is inside and moving towards it.
+static bool add_robot(obstacles &obs,vector2d p,vector2d v,double radius,
+		      vector2d bp,vector2d bv)
+{
+  if (radius <= 0) return(false);
+
+  if ((p - bp).sqlength() <= radius * radius)
+    return((bv - v).dot(p - bp) > 0.0);
+
+  obs.add_circle(p.x,p.y,radius - ROBOT_RADIUS,v.x,v.y,1);
+  return(false);
+}
+
+double ball_collision_time(World &world,ball_path &path,double time,
+			   double horizon)
+{
+  obstacles obs;
+  state s0,s1;
+  int id;
+
+  cr_setup_do();
+
+  if (horizon > path.stopped()) horizon = path.stopped();
+  if (horizon <= 0.0) return(-1);
+
+  vector2d bp = path.start(), bv = path.velocity(0);
+  double rt = DVAR(BALL_TEAMMATE_COLLISION_RADIUS);
+  double ro = DVAR(BALL_OPPONENT_COLLISION_RADIUS);
+
+  obs.clear();
+
+  for(int i=0; i<world.n_teammates; i++) {
+    if (add_robot(obs,world.teammate_position(i,time),
+		  world.teammate_velocity(i,time),rt,bp,bv))
+      return(0.0);
+  }
+
+  for(int i=0; i<world.n_opponents; i++) {
+    if (add_robot(obs,world.opponent_position(i,time),
+		  world.opponent_velocity(i,time),ro,bp,bv))
+      return(0.0);
+  }
+
+  // the circles move for the whole horizon
+  obs.set_sweep(1,horizon);
+  obs.set_mask(1);
+
+  s0.pos.set(bp.x,bp.y);
+  s0.t = 0;
+  vector2d end = path.position(horizon);
+  s1.pos.set(end.x,end.y);
+  s1.t = horizon;
+
+  return(obs.collision_time(s0,s1,id));
+}
+
+//====================================================================//
+//  Interception
+//====================================================================//
+
+double teammate_motion_time(World &world,int id,vector2d p,double time)
+{
+  vector2d r = world.teammate_position(id,time);
+  vector2d v = world.teammate_velocity(id,time);
+  Robot *robot = world.robot[id];
+  float ta,tc,td;
+
+  cr_setup_do();
+
+  if (world.teammate_type(id) == ROBOT_TYPE_DIFF) {
+    // drives straight there
+    vector2d d = p - r;
+    double dist = d.length();
+    double v0 = (dist > 0.0)? v.dot(d) / dist : 0.0;
+
+    return(robot->motion_time_1d(dist,v0,0,
+				 VDVAR(DIFF_MAX_SPEED)[Robot::GotoPointMove],
+				 VDVAR(DIFF_MAX_ACCEL)[Robot::GotoPointMove],
+				 ta,tc,td));
+  }
+
+  // each axis on its own, as goto_point_omni moves
+  double vmax = VDVAR(OMNI_MAX_SPEED)[Robot::GotoPointMove];
+  double amax = VDVAR(OMNI_MAX_ACCEL)[Robot::GotoPointMove];
+  double tx = robot->motion_time_1d(p.x - r.x,v.x,0,vmax,amax,ta,tc,td);
+  double ty = robot->motion_time_1d(p.y - r.y,v.y,0,vmax,amax,ta,tc,td);
+
+  return((tx > ty)? tx : ty);
+}
+
+int intercept_ball(World &world,double time,double horizon,
+		   ball_intercept *intercepts)
+{
+  ball_path ball;
+  int best = -1;
+
+  ball.set(world,time);
+
+  double end = (horizon < ball.stopped())? horizon : ball.stopped();
+
+  // past a deflection the path is wrong
+  double hit = ball_collision_time(world,ball,time,end);
+  if (hit >= 0.0) end = hit;
+
+  for(int i=0; i<world.n_teammates; i++) {
+    ball_intercept &c = intercepts[i];
+    double t0 = 0.0, t1 = -1.0;
+
+    // The robot is in time while the ball takes longer to get there
+    // than it does.  Find the first step where it is.
+    for(int k=0; k<=INTERCEPT_STEPS; k++) {
+      double t = end * k / INTERCEPT_STEPS;
+
+      if (teammate_motion_time(world,i,ball.position(t),time) <= t) {
+	t1 = t;
+	break;
+      }
+      t0 = t;
+    }
+
+    if (t1 > 0.0) {
+      for(int k=0; k<INTERCEPT_ITERATIONS; k++) {
+	double t = (t0 + t1) / 2;
+
+	if (teammate_motion_time(world,i,ball.position(t),time) <= t) t1 = t;
+	else t0 = t;
+      }
+    }
+
+    if (t1 >= 0.0) {
+      c.point = ball.position(t1);
+      c.time = t1;
+      c.reachable = true;
+    } else {
+      // Too late for the rolling ball; maybe not once it's stopped.
+      c.point = ball.position(end);
+      c.time = teammate_motion_time(world,i,c.point,time);
+      c.reachable = (end >= ball.stopped() && c.time <= horizon);
+      if (c.time < end) c.time = end;
+    }
+
+    if (c.reachable && (best < 0 || c.time < intercepts[best].time))
+      best = i;
+  }
+
+  return(best);
+}
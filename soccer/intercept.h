@@ -0,0 +1,97 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// Where the ball goes and who can get to it first, worked out in
+// closed form.  The ball rolls in a straight line, slowed at a
+// constant BALL_FRICTION * GRAVITY (tracker.cfg) until it stops, so
+// nothing here steps the Kalman filter forward.  That is the ball
+// tracker's prediction only until the ball hits something: the
+// tracker also deflects it off robots, so ball_collision_time() finds
+// where the path first meets one, and past that the path means
+// nothing.  (The tracker's walls are beyond anything on the field.)
+
+#ifndef __INTERCEPT_H__
+#define __INTERCEPT_H__
+
+#include "geometry.h"
+#include "constants.h"
+
+class World;
+
+class ball_path{
+  vector2d pos,dir;   // start and unit direction
+  double speed,decel; // initial speed and deceleration
+  double stop_time;   // when it comes to rest
+public:
+  ball_path() {speed=decel=stop_time=0;}
+
+  void set(vector2d p,vector2d v);
+  // the ball as the world sees it at time
+  void set(World &world,double time);
+
+  vector2d position(double t);
+  vector2d velocity(double t);
+  vector2d start() {return(pos);}
+  vector2d direction() {return(dir);}
+
+  // how far it rolls by t, and in all
+  double distance(double t);
+  double stop_distance() {return(distance(stop_time));}
+  double stopped() {return(stop_time);}
+
+  // When it has rolled s, or -1 if it stops first.
+  double time_at(double s);
+
+  // When it first crosses the line through p with unit normal n, or
+  // -1 if it stops first or is rolling away.
+  double time_to_line(vector2d p,vector2d n);
+
+  // When it first comes within r of p, or -1 if it never does.
+  double time_to_circle(vector2d p,double r);
+
+  // The time in [0,horizon] when it passes closest to p.
+  double closest_time(vector2d p,double horizon);
+};
+
+// When the ball on path, starting at time, first comes within the
+// tracker's collision radius (tracker.cfg) of a robot moving with its
+// velocity, as the tracker would deflect it, or -1 if it doesn't
+// before horizon.  It's found in closed form with the swept circle
+// test of obstacles::collision_time(), taking the ball along its path
+// at its mean speed over the horizon, which is exact for robots
+// standing still.
+double ball_collision_time(World &world,ball_path &path,double time,
+			   double horizon);
+
+struct ball_intercept{
+  vector2d point; // where the robot can meet the ball
+  double time;    // how long from now the ball gets there
+  bool reachable; // false if the robot can't get there in time
+};
+
+// How long a teammate takes to get to p and stop, from its motion
+// limits for moving (motion.cfg).
+double teammate_motion_time(World &world,int id,vector2d p,double time = -1);
+
+// For every teammate, the earliest point on the ball's path within
+// horizon seconds, and before the ball hits a robot, that it can
+// reach no later than the ball.  If it can't reach any, it gets where
+// the ball is at the end and reachable is false.  Returns the
+// teammate who meets the ball soonest, or -1 if none can.
+int intercept_ball(World &world,double time,double horizon,
+                   ball_intercept *intercepts);
+
+#endif /*__INTERCEPT_H__*/
@@ -0,0 +1,124 @@
+/*========================================================================
+    KDTreeArray.cc : Nearest neighbor benchmark for the KD Trees
+  ------------------------------------------------------------------------
+    Copyright (C) 1999-2002  James R. Bruce
+    School of Computer Science, Carnegie Mellon University
+  ------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ========================================================================*/
+
+// Build with "make kdtree_array_test".  Grows RRT-like trees the way
+// path_planner does (nearest node to a random target, then a step
+// towards it) with both KDTree and KDTreeArray, checks that they agree,
+// and reports nearest neighbor queries per second.
+
+#ifdef TEST_MAIN
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "constants.h"
+#include "obstacle.h"
+#include "kdtree.h"
+#include "kdtree_array.h"
+#include "timer.h"
+
+#define BENCH_NODES  400
+#define BENCH_TREES  2000
+#define BENCH_STEP   100
+
+static state nodes[BENCH_NODES];
+
+static vector2f random_pos()
+{
+  vector2f p;
+  p.set((FIELD_LENGTH_H+GOAL_DEPTH)*(2*drand48()-1),
+        FIELD_WIDTH_H*(2*drand48()-1));
+  return(p);
+}
+
+// Grows BENCH_TREES trees of BENCH_NODES nodes, returning the time
+// spent and storing every query's distance in dist.
+template <class tree_t>
+double grow(tree_t &tree,float *dist,long seed)
+{
+  vector2f minv,maxv,target,step;
+  state *nearest;
+  timer tm;
+  int i,j,q;
+  float d;
+
+  minv.set(-FIELD_LENGTH_H-GOAL_DEPTH,-FIELD_WIDTH_H);
+  maxv.set( FIELD_LENGTH_H+GOAL_DEPTH, FIELD_WIDTH_H);
+  tree.setdim(minv,maxv,16,8);
+
+  srand48(seed);
+  q = 0;
+  tm.start();
+
+  for(j=0; j<BENCH_TREES; j++){
+    tree.clear();
+
+    nodes[0].pos = random_pos();
+    nodes[0].parent = NULL;
+    tree.add(&nodes[0]);
+
+    for(i=1; i<BENCH_NODES; i++){
+      target = random_pos();
+      nearest = tree.nearest(d,target);
+      dist[q++] = d;
+
+      // add a node one step towards the target (or somewhere new)
+      if(nearest){
+        step = target - nearest->pos;
+        d = step.length();
+        if(d > BENCH_STEP) step *= BENCH_STEP / d;
+        nodes[i].pos = nearest->pos + step;
+      }else{
+        nodes[i].pos = target;
+      }
+      nodes[i].parent = nearest;
+      tree.add(&nodes[i]);
+    }
+  }
+
+  tm.end();
+  return(tm.time());
+}
+
+int main(int argc,char **argv)
+{
+  static KDTree<state> list_tree;
+  static KDTreeArray<state> array_tree;
+  int nq = BENCH_TREES * (BENCH_NODES - 1);
+  float *d0 = new float[nq];
+  float *d1 = new float[nq];
+  double t0,t1;
+  int i,bad;
+
+  t0 = grow(list_tree,d0,1);
+  t1 = grow(array_tree,d1,1);
+
+  bad = 0;
+  for(i=0; i<nq; i++){
+    if(fabs(d0[i] - d1[i]) > 1E-3) bad++;
+  }
+
+  printf("%d trees of %d nodes, %d queries\n",BENCH_TREES,BENCH_NODES,nq);
+  printf("%-12s %12s %10s\n","","queries/sec","usec/tree");
+  printf("%-12s %12.0f %10.1f\n","KDTree",nq/t0,t0/BENCH_TREES*1E6);
+  printf("%-12s %12.0f %10.1f\n","KDTreeArray",nq/t1,t1/BENCH_TREES*1E6);
+  if(bad) printf("%d queries disagree!\n",bad);
+
+  delete[](d0);
+  delete[](d1);
+
+  return(bad != 0);
+}
+
+#endif
@@ -0,0 +1,316 @@
+/*========================================================================
+    KDTreeArray.h : KD Tree kept in contiguous arrays
+  ------------------------------------------------------------------------
+    Copyright (C) 1999-2002  James R. Bruce
+    School of Computer Science, Carnegie Mellon University
+  ------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ========================================================================*/
+
+// A drop-in replacement for KDTree (kdtree.h) that avoids following
+// pointers around the heap.  The tree's shape is fixed by setdim(): a
+// complete tree of max_depth midpoint splits over the bounds, stored
+// implicitly (node i has children 2i+1 and 2i+2), so finding a leaf
+// takes no pointers at all.  Each node keeps a count and the tight
+// bounding box of the states below it, so empty and distant subtrees
+// are pruned much as in KDTree's adaptive splits.  Leaves keep their
+// positions in contiguous chunks of KDA_CHUNK, which are scanned
+// without branching.  Chunks come from an arena that is only grown,
+// never freed, so once a tree has grown it doesn't allocate.
+
+#ifndef __KD_TREE_ARRAY_H__
+#define __KD_TREE_ARRAY_H__
+
+#include "geometry.h"
+
+#define KDA_MAX_DEPTH 12
+#define KDA_CHUNK     8
+
+#define KDA_TEMP template <class state>
+#define KDA_FUN  KDTreeArray<state>
+
+KDA_TEMP
+class KDTreeArray{
+  struct chunk{
+    float x[KDA_CHUNK],y[KDA_CHUNK];
+    state *s[KDA_CHUNK];
+    int num;
+    int next;  // next chunk of the leaf, or -1
+  };
+
+  // per node, in implicit order
+  float *box;   // bounding box of states below (minx,miny,maxx,maxy)
+  int *count;   // number of states below
+  int *leaf;    // first chunk of each leaf, or -1
+  int depth,num_nodes,first_leaf;
+
+  chunk *chunks;
+  int num_chunks,max_chunks;
+
+  vector2f minv,maxv;
+  int tests;
+
+protected:
+  inline bool inside(state &s);
+  inline float box_sqdistance(float *b,vector2f &p);
+
+  int new_chunk();
+  void scan(chunk &c,vector2f &p,state *&best,float &best_sqdist);
+public:
+  KDTreeArray();
+  ~KDTreeArray();
+
+  // leaf_size is accepted for compatibility with KDTree; leaves are
+  // always max_depth splits deep.
+  bool setdim(vector2f &minv,vector2f &maxv,int nleaf_size,int nmax_depth);
+  bool add(state *s);
+  void clear();
+  state *nearest(float &dist,vector2f &x);
+};
+
+KDA_TEMP
+KDA_FUN::KDTreeArray()
+{
+  box = NULL;
+  count = leaf = NULL;
+  depth = num_nodes = first_leaf = 0;
+
+  chunks = NULL;
+  num_chunks = max_chunks = 0;
+}
+
+KDA_TEMP
+KDA_FUN::~KDTreeArray()
+{
+  delete[](box);
+  delete[](count);
+  delete[](leaf);
+  delete[](chunks);
+}
+
+KDA_TEMP
+inline bool KDA_FUN::inside(state &s)
+{
+  return(s.pos.x>minv.x && s.pos.y>minv.y &&
+         s.pos.x<maxv.x && s.pos.y<maxv.y);
+}
+
+KDA_TEMP
+inline float KDA_FUN::box_sqdistance(float *b,vector2f &p)
+{
+  float dx,dy;
+
+  dx = p.x - bound(p.x,b[0],b[2]);
+  dy = p.y - bound(p.y,b[1],b[3]);
+
+  return(dx*dx + dy*dy);
+}
+
+KDA_TEMP
+bool KDA_FUN::setdim(vector2f &_minv,vector2f &_maxv,
+                     int nleaf_size,int nmax_depth)
+{
+  nmax_depth = bound(nmax_depth,0,KDA_MAX_DEPTH);
+
+  if(nmax_depth != depth || !box){
+    delete[](box);
+    delete[](count);
+    delete[](leaf);
+
+    depth = nmax_depth;
+    num_nodes = (2 << depth) - 1;
+    first_leaf = (1 << depth) - 1;
+
+    box = new float[4*num_nodes];
+    count = new int[num_nodes];
+    leaf = new int[num_nodes - first_leaf];
+  }
+
+  minv = _minv;
+  maxv = _maxv;
+
+  clear();
+  return(box != NULL);
+}
+
+KDA_TEMP
+int KDA_FUN::new_chunk()
+{
+  chunk *c;
+  int i;
+
+  if(num_chunks >= max_chunks){
+    // indices stay valid when the arena moves
+    i = (max_chunks > 0)? 2*max_chunks : 64;
+    c = new chunk[i];
+    if(!c) return(-1);
+
+    memcpy(c,chunks,num_chunks*sizeof(chunk));
+    delete[](chunks);
+    chunks = c;
+    max_chunks = i;
+  }
+
+  chunks[num_chunks].num = 0;
+  chunks[num_chunks].next = -1;
+  return(num_chunks++);
+}
+
+KDA_TEMP
+bool KDA_FUN::add(state *s)
+{
+  vector2f lo,hi;
+  float *b,v;
+  int node,c,i,dim;
+
+  if(!box || !inside(*s)) return(false);
+
+  // go down the tree, growing the boxes
+  lo = minv;
+  hi = maxv;
+  node = 0;
+
+  for(i=0; ; i++){
+    b = &box[node*4];
+    if(count[node] == 0){
+      b[0] = b[2] = s->pos.x;
+      b[1] = b[3] = s->pos.y;
+    }else{
+      if(s->pos.x < b[0]) b[0] = s->pos.x;
+      if(s->pos.y < b[1]) b[1] = s->pos.y;
+      if(s->pos.x > b[2]) b[2] = s->pos.x;
+      if(s->pos.y > b[3]) b[3] = s->pos.y;
+    }
+    count[node]++;
+
+    if(node >= first_leaf) break;
+
+    // same splits as KDTree
+    dim = i % 2;
+    if(dim == 0){
+      v = (lo.x + hi.x) / 2;
+      c = (s->pos.x >= v);
+      if(c) lo.x = v; else hi.x = v;
+    }else{
+      v = (lo.y + hi.y) / 2;
+      c = (s->pos.y >= v);
+      if(c) lo.y = v; else hi.y = v;
+    }
+    node = 2*node+1 + c;
+  }
+
+  // add to the leaf's first chunk, starting a new one when full
+  c = leaf[node - first_leaf];
+  if(c < 0 || chunks[c].num >= KDA_CHUNK){
+    i = new_chunk();
+    if(i < 0) return(false);
+    chunks[i].next = c;
+    leaf[node - first_leaf] = c = i;
+  }
+
+  chunk &k = chunks[c];
+  k.x[k.num] = s->pos.x;
+  k.y[k.num] = s->pos.y;
+  k.s[k.num] = s;
+  k.num++;
+
+  return(true);
+}
+
+KDA_TEMP
+void KDA_FUN::clear()
+{
+  int i;
+
+  if(!box) return;
+
+  for(i=0; i<num_nodes; i++) count[i] = 0;
+  for(i=0; i<num_nodes-first_leaf; i++) leaf[i] = -1;
+  num_chunks = 0;
+}
+
+// Distances are computed for the whole chunk first, with no branches,
+// so the compiler can vectorize that loop.
+KDA_TEMP
+void KDA_FUN::scan(chunk &c,vector2f &p,state *&best,float &best_sqdist)
+{
+  float d[KDA_CHUNK];
+  float dx,dy;
+  int i,b;
+
+  for(i=0; i<KDA_CHUNK; i++){
+    dx = c.x[i] - p.x;
+    dy = c.y[i] - p.y;
+    d[i] = dx*dx + dy*dy;
+  }
+
+  b = -1;
+  for(i=0; i<c.num; i++){
+    if(d[i] < best_sqdist){
+      best_sqdist = d[i];
+      b = i;
+    }
+  }
+
+  if(b >= 0) best = c.s[b];
+}
+
+KDA_TEMP
+state *KDA_FUN::nearest(float &dist,vector2f &x)
+{
+  int stack[KDA_MAX_DEPTH+1];
+  float sdist[KDA_MAX_DEPTH+1];
+  state *best;
+  float best_sqdist,d[2];
+  int node,n,c,k;
+
+  best = NULL;
+  best_sqdist = 4000*4000;
+  tests = 0;
+
+  n = 0;
+  if(box && count[0] > 0){
+    stack[n] = 0;
+    sdist[n] = box_sqdistance(box,x);
+    n++;
+  }
+
+  while(n > 0){
+    n--;
+    if(sdist[n] >= best_sqdist) continue;
+    node = stack[n];
+
+    // descend to a leaf, nearer child first, saving the farther
+    while(node < first_leaf){
+      c = 2*node+1;
+      d[0] = count[c  ]? box_sqdistance(&box[ c   *4],x) : best_sqdist;
+      d[1] = count[c+1]? box_sqdistance(&box[(c+1)*4],x) : best_sqdist;
+      k = (d[1] < d[0]);
+
+      if(d[!k] < best_sqdist){
+        stack[n] = c + !k;
+        sdist[n] = d[!k];
+        n++;
+      }
+      if(d[k] >= best_sqdist) break;
+      node = c + k;
+    }
+
+    if(node >= first_leaf){
+      for(c=leaf[node-first_leaf]; c>=0; c=chunks[c].next){
+        scan(chunks[c],x,best,best_sqdist);
+        tests += chunks[c].num;
+      }
+    }
+  }
+
+  dist = sqrt(best_sqdist);
+  return(best);
+}
+
+#endif /*__KD_TREE_ARRAY_H__*/
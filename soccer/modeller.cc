@@ -1,7 +1,6 @@
 // modeller.cc
 //
-// This class holds the modeller information for histogramming the 
-// opponent team.
+// The opponent model, updated once a frame from the world.
 //
 // Created by:  Brett Browning (brettb@cs.cmu.edu)
 //
@@ -22,122 +21,359 @@
   ------------------------------------------------------------------------- */
 
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <configreader.h>
 
-#include "utils/histogram.h"
 #include "utils/geometry.h"
-#include "reality/net_vision.h"
+#include "constants.h"
+#include "commands.h"
+
+#include "world.h"
 #include "modeller.h"
 
+// Sample weights are brought back to 1 past this.
+#define MODEL_RENORMALIZE 1e20
 
-// Initialize al lthe data  
-bool Modeller::initialize(void)
+// A kick is the ball's speed rising past OPPONENT_MODEL_KICK_SPEED,
+// and the next one can't be sooner than this.
+#define MODEL_KICK_GAP 0.3 // s
+
+// Longest time step; frames further apart than this (a paused
+// program, say) aren't allowed to wipe out the model.
+#define MODEL_MAX_STEP 0.1 // s
+
+static bool cr_setup = false;
+CR_DECLARE(OPPONENT_MODEL);
+CR_DECLARE(OPPONENT_MODEL_MEMORY);
+CR_DECLARE(OPPONENT_MODEL_KICK_SPEED);
+CR_DECLARE(OPPONENT_MODEL_KICK_DIST);
+CR_DECLARE(OPPONENT_MODEL_FILE);
+CR_DECLARE(OPPONENT_MODEL_LOAD);
+
+static void cr_setup_do()
 {
-  vector2d pmax(FIELD_LENGTH_H, FIELD_WIDTH_H);
+  if (!cr_setup) {
+    CR_SETUP(strategy, OPPONENT_MODEL, CR_INT);
+    CR_SETUP(strategy, OPPONENT_MODEL_MEMORY, CR_DOUBLE);
+    CR_SETUP(strategy, OPPONENT_MODEL_KICK_SPEED, CR_DOUBLE);
+    CR_SETUP(strategy, OPPONENT_MODEL_KICK_DIST, CR_DOUBLE);
+    CR_SETUP(strategy, OPPONENT_MODEL_FILE, CR_STRING);
+    CR_SETUP(strategy, OPPONENT_MODEL_LOAD, CR_INT);
 
-  // this should come from aconfig file
-  uint xbins = 2 * ((uint) (pmax.x / 100.0));
-  uint ybins = 2 * ((uint) (pmax.y / 100.0));
+    cr_setup = true;
+  }
+}
 
-  // initialize everything
-  free_ball = 0;
-  ball_speed.set(5000.0, 0.0, 50);
-  ball_position.set(pmax, -pmax, xbins, ybins);
+void Modeller::clear()
+{
+  memset(&m,0,sizeof(m));
+  m.magic = MODEL_MAGIC;
+  m.version = MODEL_VERSION;
+  m.cells_x = MODEL_CELLS_X;
+  m.cells_y = MODEL_CELLS_Y;
+  m.scale = 1.0;
 
-  // initialize the team-based stuff
-  for (int t = 0; t < NUM_TEAMS; t++) {
-    inattack[t] = 0;
-    possession[t] = 0;
+  n_slots = 0;
+  last_time = -1;
+  last_ball_speed = HUGE_VAL;
+  last_kick = -HUGE_VAL;
+}
 
-    speed[t].set(5000.0, 0.0, 50);
-    acceleration[t].set(5000.0, 0.0, 50);
-    goalie_speed[t].set(5000.0, 0.0, 50);
-    goalie_acceleration[t].set(5000.0, 0.0, 50);
+bool Modeller::initialize(void)
+{
+  cr_setup_do();
 
-    robots_near_ball[t].set(10.0, 0.0, 10);
+  clear();
 
-    position[t].set(pmax, -pmax, xbins, ybins);
-    goalie_position[t].set(pmax, -pmax, xbins, ybins);
-    shots_on_goal[t].set(pmax, -pmax, xbins, ybins);
+  // carry on with the model from before a restart
+  if (IVAR(OPPONENT_MODEL_LOAD)) {
+    if (load(SVAR(OPPONENT_MODEL_FILE)))
+      fprintf(stderr, "Loaded opponent model: %s.\n", SVAR(OPPONENT_MODEL_FILE));
+    else
+      fprintf(stderr, "Modeller: Could not load %s, starting afresh.\n",
+	      SVAR(OPPONENT_MODEL_FILE));
   }
+
   return (true);
 }
 
+// Divides every weight by the current scale.
+void Modeller::normalize()
+{
+  double s = 1.0 / m.scale;
+
+  m.frames *= s;
+
+  for (int y = 0; y < MODEL_CELLS_Y; y++) {
+    for (int x = 0; x < MODEL_CELLS_X; x++)
+      m.occupancy[y][x] *= s;
+  }
+
+  for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
+    opponent_model::robot_model &r = m.robot[i];
+
+    r.w *= s;
+    r.vx *= s;
+    r.vy *= s;
+    r.vxx *= s;
+    r.vyy *= s;
+    for (int b = 0; b < MODEL_SPEED_BINS; b++) r.speed[b] *= s;
+  }
+
+  m.kicks *= s;
+  m.kick_x *= s;
+  m.kick_y *= s;
+  for (int b = 0; b < MODEL_KICK_BINS; b++) m.kick_dir[b] *= s;
+
+  m.shots *= s;
+  m.shot_y *= s;
+  m.shot_yy *= s;
+  for (int b = 0; b < MODEL_SHOT_BINS; b++) m.shot_bin[b] *= s;
+
+  m.scale = 1.0;
+}
+
+// The kick direction bin whose center is nearest angle.
+static int kick_bin(double angle)
+{
+  int b = (int) floor((angle + M_PI) / (2 * M_PI) * MODEL_KICK_BINS + 0.5);
+
+  b %= MODEL_KICK_BINS;
+  if (b < 0) b += MODEL_KICK_BINS;
+
+  return (b);
+}
+
+void Modeller::add_kick(vector2d p, vector2d v, double w)
+{
+  vector2d d = v.norm();
+
+  m.kicks += w;
+  m.kick_x += w * d.x;
+  m.kick_y += w * d.y;
+  m.kick_dir[kick_bin(atan2(d.y, d.x))] += w;
+
+  // where it would cross our goal line
+  if (v.x >= 0.0) return;
+
+  double y = p.y + v.y * (-FIELD_LENGTH_H - p.x) / v.x;
+  if (fabs(y) > GOAL_WIDTH_H) return;
+
+  int b = (int) ((y + GOAL_WIDTH_H) / GOAL_WIDTH * MODEL_SHOT_BINS);
+  if (b > MODEL_SHOT_BINS - 1) b = MODEL_SHOT_BINS - 1;
+  if (b < 0) b = 0;
+
+  m.shots += w;
+  m.shot_y += w * y;
+  m.shot_yy += w * y * y;
+  m.shot_bin[b] += w;
+}
+
+void Modeller::update(World &world)
+{
+  cr_setup_do();
+
+  double dt = (last_time < 0) ? 0.0 : world.time - last_time;
+  last_time = world.time;
+
+  n_slots = world.n_opponents;
+  if (n_slots > MAX_TEAM_ROBOTS) n_slots = MAX_TEAM_ROBOTS;
+  for (int i = 0; i < n_slots; i++)
+    slot[i] = world.opponent_vision_id(i);
+
+  if (!IVAR(OPPONENT_MODEL)) return;
+
+  bool stopped = (world.game_state == COMM_STOP ||
+		  world.game_state == COMM_HALF_TIME);
+
+  // keep what we have each time play stops, for a restart
+  if (stopped && world.game_state != world.prev_game_state && m.frames > 0.0)
+    save(SVAR(OPPONENT_MODEL_FILE));
+
+  vector2d ball = world.ball_position();
+  vector2d ball_v = world.ball_velocity();
+  double ball_speed = ball_v.length();
+
+  if (stopped) {
+    last_ball_speed = ball_speed;
+    return;
+  }
+
+  // fade out the old by weighting the new more
+  if (!(dt > 0.0)) dt = 0.0;
+  if (dt > MODEL_MAX_STEP) dt = MODEL_MAX_STEP;
+
+  m.scale *= exp(dt / DVAR(OPPONENT_MODEL_MEMORY));
+  if (m.scale > MODEL_RENORMALIZE) normalize();
+
+  double w = m.scale;
+  m.frames += w;
+
+  for (int i = 0; i < n_slots; i++) {
+    vector2d p = world.opponent_position(i);
+    vector2d v = world.opponent_velocity(i);
+
+    int cx = (int) ((p.x + FIELD_LENGTH_H) / MODEL_CELL);
+    int cy = (int) ((p.y + FIELD_WIDTH_H) / MODEL_CELL);
+    if (cx >= 0 && cx < MODEL_CELLS_X && cy >= 0 && cy < MODEL_CELLS_Y)
+      m.occupancy[cy][cx] += w;
+
+    if (slot[i] < 0 || slot[i] >= MAX_TEAM_ROBOTS) continue;
+    opponent_model::robot_model &r = m.robot[slot[i]];
+
+    r.w += w;
+    r.vx += w * v.x;
+    r.vy += w * v.y;
+    r.vxx += w * v.x * v.x;
+    r.vyy += w * v.y * v.y;
+
+    int b = (int) (v.length() / MODEL_SPEED_BIN);
+    if (b > MODEL_SPEED_BINS - 1) b = MODEL_SPEED_BINS - 1;
+    r.speed[b] += w;
+  }
+
+  // A kick by them: the ball has just sped up, moving away from an
+  // opponent who is next to it and nearer than any of us.
+  double kick_speed = DVAR(OPPONENT_MODEL_KICK_SPEED);
+
+  if (ball_speed > kick_speed && last_ball_speed <= kick_speed &&
+      world.time - last_kick > MODEL_KICK_GAP) {
+    int k = world.nearest_opponent(ball);
+
+    if (k >= 0) {
+      vector2d p = world.opponent_position(k);
+      int t = world.nearest_teammate(ball);
+      double d = (ball - p).length();
 
-void Modeller::update(const net_vframe &frame)
-{
-  // update the non-team based histograms
-  vector2d v((double) frame.ball.state.vx, (double) frame.ball.state.vy);
-  ball_speed.add(v.length());
-  vector2d ball(vector2d((double) frame.ball.state.x, (double) frame.ball.state.y));
-  ball_position.add(ball);
-
-  // this one is wrong
-  if (frame.ball.state.x > 0)
-    inattack[TEAM_BLUE]++;
-  else
-    inattack[TEAM_YELLOW]++;
-
-  // work out who is closest to the ball
-  int nr_near_ball[NUM_TEAMS];
-  int closest = TEAM_BLUE;
-  double minsqdist = HUGE_VAL;
-
-  // range to the ball for considered near ball
-  double rangesq = 300.0 * 300.0;
-
-  for (int t = 0; t < NUM_TEAMS; t++) {
-    int goalie;
-    double goaliesqdist = HUGE_VAL;
-    vector2d goalie_pos(0,0), goalie_vel(0,0);
-
-    nr_near_ball[t] = 0;
-    for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      if (frame.config.teams[t].robots[i].id >= 0) {
-	vector2d p(frame.robots[t][i].state.x, frame.robots[t][i].state.y);
-	vector2d v(frame.robots[t][i].state.vx, frame.robots[t][i].state.vy);
-
-	position[t].add(p);
-	speed[t].add(v.length());
-
-	// workout goalie info
-	vector2d goal(-FIELD_LENGTH_H, 0);
-	if (t == TEAM_YELLOW)
-	  goal = -goal;
-	double d = (goal - p).sqlength();
-
-	if (d < goaliesqdist) {
-	  goaliesqdist = d;
-	  goalie = i;
-	  goalie_pos = p;
-	  goalie_vel = v;
-	}
-
-	// work out possession info
-	d = (ball - p).sqlength();
-	if (d < minsqdist) {
-	  minsqdist = d;
-	  closest = t;
-	}
-	if (d < rangesq)
-	  nr_near_ball[t]++;
+      if (d < DVAR(OPPONENT_MODEL_KICK_DIST) && (ball - p).dot(ball_v) > 0.0 &&
+	  (t < 0 || (ball - world.teammate_position(t)).length() > d)) {
+	add_kick(ball, ball_v, w);
+	last_kick = world.time;
       }
     }
-    robots_near_ball[t].add(nr_near_ball[t]);
-    goalie_position[t].add(goalie_pos);
-    goalie_speed[t].add(goalie_vel.length());
   }
 
-  // now add to possession
-  // need to make this smarter
-  if (minsqdist < 100.0 * 100.0) {
-    possession[closest]++;
-  } else {
-    free_ball++;
+  last_ball_speed = ball_speed;
+}
+
+double Modeller::occupancy(vector2d p)
+{
+  int cx = (int) ((p.x + FIELD_LENGTH_H) / MODEL_CELL);
+  int cy = (int) ((p.y + FIELD_WIDTH_H) / MODEL_CELL);
+
+  if (m.frames <= 0.0 ||
+      !(cx >= 0 && cx < MODEL_CELLS_X && cy >= 0 && cy < MODEL_CELLS_Y))
+    return (0.0);
+
+  return (m.occupancy[cy][cx] / m.frames);
+}
+
+bool Modeller::velocity(int id, vector2d &mean, vector2d &sd)
+{
+  if (id < 0 || id >= n_slots) return (false);
+  if (slot[id] < 0 || slot[id] >= MAX_TEAM_ROBOTS) return (false);
+
+  opponent_model::robot_model &r = m.robot[slot[id]];
+  if (r.w <= 0.0) return (false);
+
+  mean.set(r.vx / r.w, r.vy / r.w);
+
+  double sx = r.vxx / r.w - mean.x * mean.x;
+  double sy = r.vyy / r.w - mean.y * mean.y;
+  sd.set(sqrt((sx > 0.0) ? sx : 0.0), sqrt((sy > 0.0) ? sy : 0.0));
+
+  return (true);
+}
+
+double Modeller::speed_quantile(int id, double q)
+{
+  if (id < 0 || id >= n_slots) return (-1);
+  if (slot[id] < 0 || slot[id] >= MAX_TEAM_ROBOTS) return (-1);
+
+  opponent_model::robot_model &r = m.robot[slot[id]];
+  if (r.w <= 0.0) return (-1);
+
+  // the bins add up to r.w, give or take float rounding
+  double target = q * r.w, sum = 0.0;
+
+  for (int b = 0; b < MODEL_SPEED_BINS; b++) {
+    double h = r.speed[b];
+
+    if (h > 0.0 && sum + h >= target)
+      return ((b + (target - sum) / h) * MODEL_SPEED_BIN);
+    sum += h;
   }
 
-  // need to work out shots on goal here
+  return (MODEL_SPEED_BINS * MODEL_SPEED_BIN);
 }
-    
 
+double Modeller::kick_direction(double &concentration)
+{
+  if (m.kicks <= 0.0) {
+    concentration = 0.0;
+    return (0.0);
+  }
+
+  concentration = sqrt(m.kick_x * m.kick_x + m.kick_y * m.kick_y) / m.kicks;
+  return (atan2(m.kick_y, m.kick_x));
+}
 
- 
+double Modeller::kick_probability(double angle)
+{
+  if (m.kicks <= 0.0) return (0.0);
+
+  return (m.kick_dir[kick_bin(angle)] / m.kicks);
+}
+
+bool Modeller::shot_target(double &y, double &spread)
+{
+  if (m.shots <= 0.0) return (false);
+
+  y = m.shot_y / m.shots;
+
+  double v = m.shot_yy / m.shots - y * y;
+  spread = sqrt((v > 0.0) ? v : 0.0);
+
+  return (true);
+}
+
+bool Modeller::restore(const opponent_model &s)
+{
+  // from another build, with other bins
+  if (s.magic != MODEL_MAGIC || s.version != MODEL_VERSION ||
+      s.cells_x != MODEL_CELLS_X || s.cells_y != MODEL_CELLS_Y ||
+      !(s.scale >= 1.0))
+    return (false);
+
+  m = s;
+  return (true);
+}
+
+bool Modeller::save(const char *filename)
+{
+  FILE *out = fopen(filename, "wb");
+  if (!out) {
+    fprintf(stderr, "Modeller: Could not write %s.\n", filename);
+    return (false);
+  }
+
+  bool ok = (fwrite(&m, sizeof(m), 1, out) == 1);
+  if (fclose(out) != 0) ok = false;
+
+  return (ok);
+}
+
+bool Modeller::load(const char *filename)
+{
+  opponent_model s;
+
+  FILE *in = fopen(filename, "rb");
+  if (!in) return (false);
+
+  bool ok = (fread(&s, sizeof(s), 1, in) == 1);
+  fclose(in);
+
+  return (ok && restore(s));
+}
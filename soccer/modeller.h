@@ -1,7 +1,7 @@
 // modeller.h
 //
-// This class holds the modeller information for histogramming the 
-// opponent team.
+// A running model of the opponent team: where they spend their time,
+// how fast each of them moves, and which way they kick.
 //
 // Created by:  Brett Browning (brettb@cs.cmu.edu)
 //
@@ -21,52 +21,130 @@
     including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
   ------------------------------------------------------------------------- */
 
+// Everything is kept in the world's frame (our goal at -x), so the
+// model still holds after the teams change ends at half time.  Old
+// frames fade with time constant OPPONENT_MODEL_MEMORY (strategy.cfg).
+// Rather than multiply every bin down each frame, new samples are
+// added with a weight that grows by the same factor, and the queries
+// only use ratios, so an update touches a fixed number of bins.  The
+// weights are brought back down, all at once, long before they
+// overflow.
+//
+// Robots are followed by their vision slot, which stays the same
+// while World's opponent indices shuffle as robots come and go.
+
 #ifndef __MODELLER_H__
 #define __MODELLER_H__
 
 #include <stdio.h>
 
-#include "utils/histogram.h"
 #include "utils/geometry.h"
-#include "reality/net_vision.h"
 #include "constants.h"
 
+class World;
+
+// occupancy cells, from wall to wall
+#define MODEL_CELL 200.0 // mm
+#define MODEL_CELLS_X ((int)(FIELD_LENGTH / MODEL_CELL) + 1)
+#define MODEL_CELLS_Y ((int)(FIELD_WIDTH / MODEL_CELL) + 1)
+
+// speed histogram per robot; the last bin holds everything faster
+#define MODEL_SPEED_BINS 16
+#define MODEL_SPEED_BIN 200.0 // mm/s
+
+// kick directions, and where shots cross our goal line
+#define MODEL_KICK_BINS 16
+#define MODEL_SHOT_BINS 12
+
+#define MODEL_MAGIC 0x4d4f5050 // "OPPM"
+#define MODEL_VERSION 1
+
+// All of the model, with no pointers, so it can be copied as a
+// snapshot and written to a file as it is.
+struct opponent_model{
+  int magic,version;
+  int cells_x,cells_y;
+
+  double scale;  // weight of a sample added now
+  double frames; // weighted frames seen
+
+  // opponents per cell
+  float occupancy[MODEL_CELLS_Y][MODEL_CELLS_X];
+
+  // for each vision slot: weight, sums of velocity and its square,
+  // and a histogram of speeds
+  struct robot_model{
+    double w;
+    double vx,vy,vxx,vyy;
+    float speed[MODEL_SPEED_BINS];
+  } robot[MAX_TEAM_ROBOTS];
+
+  // kicks: weight, resultant of unit directions, histogram of angles
+  double kicks;
+  double kick_x,kick_y;
+  float kick_dir[MODEL_KICK_BINS];
+
+  // kicks that would cross our goal line between the posts: weight,
+  // sums of y and its square, and a histogram across the goal
+  double shots;
+  double shot_y,shot_yy;
+  float shot_bin[MODEL_SHOT_BINS];
+};
+
 class Modeller {
-public:
-  Histogram1D speed[NUM_TEAMS], acceleration[NUM_TEAMS];
-  Histogram1D goalie_speed[NUM_TEAMS], goalie_acceleration[NUM_TEAMS];
-  Histogram2D position[NUM_TEAMS], goalie_position[NUM_TEAMS];
-
-  // Histogram3D position3D;
-
-  Histogram2D ball_position;
-  Histogram1D ball_speed;
-//  Histogram2D ball_position;
-  
-  // misc stats
-  // number of times in attack or defense
-  // defined
-  uint inattack[NUM_TEAMS];
-  uint possession[NUM_TEAMS], free_ball;
-  
-  Histogram1D robots_near_ball[NUM_TEAMS];
-
-  // from where were shots on goal fired
-  Histogram2D shots_on_goal[NUM_TEAMS];
+  opponent_model m;
+
+  // world index to vision slot, from the last update
+  int slot[MAX_TEAM_ROBOTS];
+  int n_slots;
+
+  // the last frame, for the time step and finding kicks
+  double last_time;
+  double last_ball_speed;
+  double last_kick;
 
+  void clear();
+  void normalize();
+  void add_kick(vector2d p,vector2d v,double w);
 public:
-  
-  Modeller(void) {}
+  Modeller(void) {clear();}
   ~Modeller(void) {}
 
   bool initialize(void);
-  void update(const net_vframe &frame);
-  
-  // operations to retrieve useful information
-  
-  
-  
-};
+  void update(World &world);
+
+  // Queries.  Opponents are World's indices into this frame's
+  // opponents, as for opponent_position().
+
+  // Fraction of the time an opponent has been in the cell around p.
+  double occupancy(vector2d p);
 
+  // Mean and standard deviation of an opponent's velocity.  False
+  // before any frames of it.
+  bool velocity(int id,vector2d &mean,vector2d &sd);
+
+  // The speed an opponent moves at or below for a fraction q of the
+  // time, or -1 before any frames of it.
+  double speed_quantile(int id,double q);
+
+  // Weighted number of kicks seen, their mean direction, and how much
+  // they agree on it (0 all over the place, 1 always the same way).
+  double kick_count() {return(m.kicks / m.scale);}
+  double kick_direction(double &concentration);
+
+  // Fraction of kicks within a sixteenth of a circle around angle.
+  double kick_probability(double angle);
+
+  // Weighted number of kicks at our goal, and where across it they go
+  // on average and how widely.  False if there have been none.
+  double shot_count() {return(m.shots / m.scale);}
+  bool shot_target(double &y,double &spread);
+
+  // Snapshot and restore, in memory or through a file.
+  void snapshot(opponent_model &s) {s = m;}
+  bool restore(const opponent_model &s);
+  bool save(const char *filename);
+  bool load(const char *filename);
+};
 
 #endif
@@ -20,6 +20,7 @@
 #include "constants.h"
 
 #include "obstacle.h"
+#include "distance_field.h"
 
 
 //====================================================================//
@@ -178,6 +179,62 @@ vector2f obstacle::repulse(state s)
   return(v * f);
 }
 
+// In the frame moving with the circle the robot goes in a straight
+// line, so contact is the smaller root of |d0 + w*u|^2 = r^2 over the
+// step u in [0,1].  A step across horizon is split there, since after
+// it the circle stands still.
+float obstacle::collision_time(state s0,state s1,float horizon)
+{
+  state m;
+  vector2f c0,cv,d0,w;
+  float t,dt,r,a,b,c,disc,u;
+
+  if(type != OBS_CIRCLE) return(check(s0,s1)? -1 : s0.t);
+
+  if(s0.t < horizon && s1.t > horizon){
+    m.pos = s0.pos + (s1.pos - s0.pos)*((horizon - s0.t)/(s1.t - s0.t));
+    m.t = horizon;
+    t = collision_time(s0,m,horizon);
+    return((t >= 0)? t : collision_time(m,s1,horizon));
+  }
+
+  if(s0.t < horizon){
+    c0 = pos + vel*s0.t;
+    cv = vel;
+  }else{
+    c0 = pos + vel*horizon;
+    cv.set(0,0);
+  }
+
+  r = rad.x + ROBOT_RADIUS;
+  d0 = s0.pos - c0;
+  c = d0.sqlength() - r*r;
+  if(c <= 0) return(s0.t);
+
+  dt = s1.t - s0.t;
+  w = (s1.pos - s0.pos) - cv*dt;
+  a = w.sqlength();
+  b = d0.dot(w);
+  disc = b*b - a*c;
+  if(a < EPSILON || b >= 0 || disc < 0) return(-1);
+
+  u = (-b - sqrt(disc)) / a;
+  return((u <= 1)? s0.t + u*dt : -1);
+}
+
+void obstacle_group::add(int i,vector2f pos,vector2f rad,vector2f vel)
+{
+  x[num] = pos.x;
+  y[num] = pos.y;
+  rx[num] = rad.x;
+  ry[num] = rad.y;
+  vx[num] = vel.x;
+  vy[num] = vel.y;
+  id[num] = i;
+
+  num++;
+}
+
 //====================================================================//
 //    Obstacles class implementation
 //====================================================================//
@@ -191,8 +248,10 @@ void obstacles::add_rectangle(float cx,float cy,float w,float h,int mask)
   obs[num].pos.set(cx,cy);
   obs[num].rad.set(w/2,h/2);
   obs[num].vel.set(0,0);
+  rects.add(num,obs[num].pos,obs[num].rad,obs[num].vel);
 
   num++;
+  update_enabled();
 }
 
 void obstacles::add_circle(float x,float y,float radius,
@@ -205,8 +264,10 @@ void obstacles::add_circle(float x,float y,float radius,
   obs[num].pos.set(x,y);
   obs[num].rad.set(radius,radius);
   obs[num].vel.set(vx,vy);
+  circles.add(num,obs[num].pos,obs[num].rad,obs[num].vel);
 
   num++;
+  update_enabled();
 }
 
 void obstacles::add_half_plane(float x,float y,float nx,float ny,int mask)
@@ -218,8 +279,126 @@ void obstacles::add_half_plane(float x,float y,float nx,float ny,int mask)
   obs[num].pos.set(x,y);
   obs[num].rad.set(nx,ny);
   obs[num].vel.set(0,0);
+  planes.add(num,obs[num].pos,obs[num].rad,obs[num].vel);
 
   num++;
+  update_enabled();
+}
+
+void obstacles::add_static(distance_field &f,int flags,int mask)
+{
+  field = &f;
+  field_flags = flags;
+  field_mask = mask;
+  update_enabled();
+}
+
+void obstacles::update_enabled()
+{
+  int i;
+
+  // This keeps the test the checks have always used,
+  // "obs[i].mask&current_mask==0", which parses as
+  // mask&(current_mask==0).  So with a nonzero current_mask every
+  // obstacle is checked, and with a zero one only those without bit 0.
+  enabled = 0;
+  for(i=0; i<num; i++){
+    if(!(obs[i].mask & (current_mask==0))) enabled |= 1U << i;
+  }
+
+  field_enabled = field && !(field_mask & (current_mask==0));
+}
+
+// Returns the set of obstacles (as bits of their index) that a robot
+// at s would hit.  The loops over circles and half planes have no
+// branches so the compiler can vectorize them.
+unsigned obstacles::check_hits(state s)
+{
+  const float r2 = ROBOT_RADIUS*ROBOT_RADIUS;
+  float px = s.pos.x, py = s.pos.y;
+  float dx,dy,r,d,t;
+  unsigned hits = 0;
+  int i;
+
+  // how far the circles have moved
+  t = (sweep_speed > 0)? ((s.t < sweep_horizon)? s.t : sweep_horizon) : 0;
+
+  for(i=0; i<circles.num; i++){
+    dx = px - (circles.x[i] + circles.vx[i]*t);
+    dy = py - (circles.y[i] + circles.vy[i]*t);
+    r  = circles.rx[i] + ROBOT_RADIUS;
+    hits |= (unsigned)(dx*dx + dy*dy <= r*r) << circles.id[i];
+  }
+
+  for(i=0; i<rects.num; i++){
+    dx = fabs(px - rects.x[i]) - rects.rx[i];
+    dy = fabs(py - rects.y[i]) - rects.ry[i];
+    dx = (dx > 0)? dx : 0;
+    dy = (dy > 0)? dy : 0;
+    hits |= (unsigned)(dx*dx + dy*dy <= r2) << rects.id[i];
+  }
+
+  for(i=0; i<planes.num; i++){
+    d = (px - planes.x[i])*planes.rx[i] + (py - planes.y[i])*planes.ry[i];
+    hits |= (unsigned)(d <= ROBOT_RADIUS) << planes.id[i];
+  }
+
+  return(hits);
+}
+
+// Returns the set of obstacles that a robot moving from s0 to s1 would
+// hit.  Rectangles are few (the defense areas) and keep the exact
+// per-obstacle sweep test.  When sweeping, each circle is checked in
+// the frame moving with it, where the robot's step is still a segment
+// and its closest approach is to the center.
+unsigned obstacles::check_hits(state s0,state s1)
+{
+  float sx,sy,l,f,dx,dy,ax,ay,wx,wy,r,d,d0,d1,ta,tb;
+  unsigned hits = 0;
+  int i;
+
+  sx = s1.pos.x - s0.pos.x;
+  sy = s1.pos.y - s0.pos.y;
+
+  if(sweep_speed > 0){
+    ta = (s0.t < sweep_horizon)? s0.t : sweep_horizon;
+    tb = (s1.t < sweep_horizon)? s1.t : sweep_horizon;
+  }else{
+    if(sqrt(sx*sx + sy*sy) < EPSILON) return(check_hits(s0));
+    ta = tb = 0;
+  }
+
+  for(i=0; i<circles.num; i++){
+    // nearest point on the relative segment to the center
+    ax = s0.pos.x - (circles.x[i] + circles.vx[i]*ta);
+    ay = s0.pos.y - (circles.y[i] + circles.vy[i]*ta);
+    wx = sx - circles.vx[i]*(tb - ta);
+    wy = sy - circles.vy[i]*(tb - ta);
+    l = wx*wx + wy*wy + EPSILON;
+    f = -(ax*wx + ay*wy) / l;
+    f = (f > 0)? f : 0;
+    f = (f < 1)? f : 1;
+    dx = ax + wx*f;
+    dy = ay + wy*f;
+    r  = circles.rx[i] + ROBOT_RADIUS;
+    hits |= (unsigned)(dx*dx + dy*dy <= r*r) << circles.id[i];
+  }
+
+  for(i=0; i<rects.num; i++){
+    if((enabled & (1U << rects.id[i])) && !obs[rects.id[i]].check(s0,s1))
+      hits |= 1U << rects.id[i];
+  }
+
+  for(i=0; i<planes.num; i++){
+    d0 = (s0.pos.x - planes.x[i])*planes.rx[i] +
+         (s0.pos.y - planes.y[i])*planes.ry[i];
+    d1 = (s1.pos.x - planes.x[i])*planes.rx[i] +
+         (s1.pos.y - planes.y[i])*planes.ry[i];
+    d = (d0 < d1)? d0 : d1;
+    hits |= (unsigned)(d <= ROBOT_RADIUS) << planes.id[i];
+  }
+
+  return(hits);
 }
 
 bool obstacles::check(vector2d p)
@@ -238,50 +417,83 @@ bool obstacles::check(vector2d p,int &id)
   return(check(s,id));
 }
 
-bool obstacles::check(state s)
+bool obstacles::check_static(state s)
 {
-  int i;
+  if(!field_enabled) return(true);
+  return(field->distance(s.pos,field_flags) > ROBOT_RADIUS);
+}
 
-  i = 0;
-  while(i<num && (obs[i].mask&current_mask==0 || obs[i].check(s))) i++;
+bool obstacles::check_static(state s0,state s1)
+{
+  if(!field_enabled) return(true);
+  return(field->check(s0.pos,s1.pos,field_flags,ROBOT_RADIUS));
+}
 
-  return(i == num);
+bool obstacles::check(state s)
+{
+  return((check_hits(s) & enabled) == 0 && check_static(s));
 }
 
 bool obstacles::check(state s,int &id)
 {
-  int i;
+  unsigned hits = check_hits(s) & enabled;
+
+  // the first obstacle hit, in the order they were added
+  if(hits){
+    id = __builtin_ctz(hits);
+    return(false);
+  }
 
-  i = 0;
-  while(i<num && (obs[i].mask&current_mask==0 || obs[i].check(s))) i++;
-  if(i < num) id = i;
+  if(!check_static(s)){
+    id = -1;
+    return(false);
+  }
 
-  return(i == num);
+  return(true);
 }
 
 bool obstacles::check(state s0,state s1)
 {
-  int i;
+  return((check_hits(s0,s1) & enabled) == 0 && check_static(s0,s1));
+}
+
+bool obstacles::check(state s0,state s1,int &id)
+{
+  unsigned hits = check_hits(s0,s1) & enabled;
+
+  if(hits){
+    id = __builtin_ctz(hits);
+    return(false);
+  }
 
-  i = 0;
-  while(i<num && (obs[i].mask&current_mask==0 || obs[i].check(s0,s1))){
-    // printf("%d",obs[i].check(s0,s1));
-    i++;
+  if(!check_static(s0,s1)){
+    id = -1;
+    return(false);
   }
-  // printf("\n");
 
-  return(i == num);
+  return(true);
 }
 
-bool obstacles::check(state s0,state s1,int &id)
+float obstacles::collision_time(state s0,state s1,int &id)
 {
-  int i;
+  float h,t,best;
+  int i,j;
 
-  i = 0;
-  while(i<num && (obs[i].mask&current_mask==0 || obs[i].check(s0,s1))) i++;
-  if(i < num) id = i;
+  h = (sweep_speed > 0)? sweep_horizon : 0;
+  best = -1;
+
+  for(j=0; j<circles.num; j++){
+    i = circles.id[j];
+    if(!is_enabled(i)) continue;
+
+    t = obs[i].collision_time(s0,s1,h);
+    if(t>=0 && (best<0 || t<best)){
+      best = t;
+      id = i;
+    }
+  }
 
-  return(i == num);
+  return(best);
 }
 
 vector2f obstacles::repulse(state s)
@@ -296,5 +508,51 @@ vector2f obstacles::repulse(state s)
     }
   }
 
+  if(!check_static(s)) f += field->gradient(s.pos,field_flags);
+
   return(f);
 }
+
+void obstacles::write(FILE *out)
+{
+  obstacle *o;
+  int i;
+
+  fprintf(out,"obstacles %d %d %.1f %.3f\n",
+          num,current_mask,sweep_speed,sweep_horizon);
+  for(i=0; i<num; i++){
+    o = &obs[i];
+    fprintf(out,"obs %d %d %.1f %.1f %.3f %.3f %.1f %.1f\n",
+            o->type,o->mask,o->pos.x,o->pos.y,
+            o->rad.x,o->rad.y,o->vel.x,o->vel.y);
+  }
+  if(field) fprintf(out,"static %d %d\n",field_flags,field_mask);
+}
+
+bool obstacles::read(FILE *in,distance_field &f)
+{
+  float px,py,rx,ry,vx,vy,speed,horizon;
+  int n,cmask,mask,type,flags,i;
+
+  clear();
+  if(fscanf(in," obstacles %d %d %f %f",
+            &n,&cmask,&speed,&horizon) != 4) return(false);
+  set_sweep(speed,horizon);
+
+  for(i=0; i<n; i++){
+    if(fscanf(in," obs %d %d %f %f %f %f %f %f",
+              &type,&mask,&px,&py,&rx,&ry,&vx,&vy) != 8) return(false);
+
+    switch(type){
+      case OBS_CIRCLE:     add_circle(px,py,rx,vx,vy,mask); break;
+      case OBS_RECTANGLE:  add_rectangle(px,py,2*rx,2*ry,mask); break;
+      case OBS_HALF_PLANE: add_half_plane(px,py,rx,ry,mask); break;
+      default: return(false);
+    }
+  }
+
+  if(fscanf(in," static %d %d",&flags,&mask) == 2) add_static(f,flags,mask);
+  set_mask(cmask);
+
+  return(true);
+}
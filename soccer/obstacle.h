@@ -17,8 +17,12 @@
 #ifndef __OBSTACLE_H__
 #define __OBSTACLE_H__
 
+#include <stdio.h>
+
 #include "geometry.h"
 
+class distance_field;
+
 #define ROBOT_RADIUS ROBOT_DEF_WIDTH_H
 
 #define OBS_RECTANGLE  0
@@ -28,6 +32,7 @@
 struct state{
   vector2f pos;
   // vector2f vel;
+  float t; // when the robot gets here, for sweep checks (see set_sweep())
   state *parent;
   state *next;
 };
@@ -53,26 +58,74 @@ public:
   bool check(state s0,state s1);
   vector2f repulse(state s);
   // state tangent(state s0,state s1);
+
+  // When a robot moving from s0 (at s0.t) to s1 (at s1.t) first
+  // touches this obstacle, moving with vel until horizon, or -1 if it
+  // doesn't.  Only circles move; other types give s0.t or -1.
+  float collision_time(state s0,state s1,float horizon);
 };
 
 #define MAX_OBSTACLES 24
 // 2*MAX_TEAM_ROBOTS+1+2+4
 // robots, ball, defense areas, walls
+// (at most 32, as hit sets are kept as bits of an unsigned)
+
+// Structure-of-arrays copy of the obstacles of a single type, so the
+// checks can run over each type without branching.  id[] maps back to
+// the obstacle's index in obstacles::obs.
+struct obstacle_group{
+  int num;
+  float x[MAX_OBSTACLES],y[MAX_OBSTACLES];   // center (or plane point)
+  float rx[MAX_OBSTACLES],ry[MAX_OBSTACLES]; // radii (or plane normal)
+  float vx[MAX_OBSTACLES],vy[MAX_OBSTACLES]; // velocity
+  int id[MAX_OBSTACLES];
+  void add(int i,vector2f pos,vector2f rad,vector2f vel);
+};
 
 class obstacles{
 public:
   obstacle obs[MAX_OBSTACLES];
   int num,current_mask;
+private:
+  obstacle_group circles,rects,planes;
+  unsigned enabled; // bit i set if obs[i] is checked under current_mask
+
+  // the static obstacles, if any (see add_static())
+  distance_field *field;
+  int field_flags,field_mask;
+  bool field_enabled;
+
+  // see set_sweep()
+  float sweep_speed,sweep_horizon;
+
+  void update_enabled();
+  unsigned check_hits(state s);
+  unsigned check_hits(state s0,state s1);
 public:
-  obstacles() {num=current_mask=0;}
+  obstacles() {current_mask=0; sweep_speed=sweep_horizon=0; clear();}
 
-  void clear() {num = 0;}
+  void clear() {num = circles.num = rects.num = planes.num = 0; enabled = 0;
+                field = NULL; field_enabled = false;}
   void add_rectangle(float cx,float cy,float w,float h,int mask);
   void add_circle(float x,float y,float radius,
 		  float vx,float vy,int mask);
   void add_half_plane(float x,float y,float nx,float ny,int mask);
 
-  void set_mask(int mask) {current_mask = mask;}
+  // Adds the walls and defense zones in obstacle flags as one
+  // obstacle, checked by looking up f.  f must outlive this object.
+  // Hits on it report an id of -1.
+  void add_static(distance_field &f,int flags,int mask);
+
+  // With a nonzero speed, circles move with their velocities for
+  // horizon seconds, and the checks place them at the time in each
+  // state rather than where they were added.  speed is how fast the
+  // planner should assume the robot goes when timing its states.
+  void set_sweep(float speed,float horizon)
+    {sweep_speed = speed; sweep_horizon = horizon;}
+  float get_sweep_speed() {return(sweep_speed);}
+
+  void set_mask(int mask) {current_mask = mask; update_enabled();}
+  bool is_enabled(int i) {return((enabled >> i) & 1);}
   bool check(vector2d p);
   bool check(vector2d p,int &id);
   bool check(state s);
@@ -80,6 +133,20 @@ public:
   bool check(state s0,state s1);
   bool check(state s0,state s1,int &id);
   vector2f repulse(state s);
+
+  // When a robot moving from s0 to s1 first touches an enabled
+  // circle, found in closed form, or -1 if it doesn't.  id is set to
+  // the circle.  Circles move only if sweeping.
+  float collision_time(state s0,state s1,int &id);
+
+  // checks against only the add_static() obstacles
+  bool check_static(state s);
+  bool check_static(state s0,state s1);
+
+  // One line per obstacle, as text.  read() attaches static obstacles
+  // to f, and returns false at the end of the file or on bad input.
+  void write(FILE *out);
+  bool read(FILE *in,distance_field &f);
 };
 
 #endif /*__OBSTACLE_H__*/
@@ -15,14 +15,25 @@
   ------------------------------------------------------------------------- */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "geometry.h"
 #include "constants.h"
 #include "win.h"
 
+#include "configreader.h"
+#include "timer.h"
+
 #include "obstacle.h"
 #include "path_planner.h"
 
+CR_DECLARE(PLAN_FAR_WEIGHT);
+CR_DECLARE(PLAN_REUSE);
+CR_DECLARE(PLAN_REUSE_GOAL_DIST);
+CR_DECLARE(PLAN_REPAIR_TRIES);
+CR_DECLARE(PLAN_KINO_STEP);
+CR_DECLARE(PLAN_KINO_HORIZON);
+
 /*
 extern xwin field;
 void DrawLine(xdrawable &w,double x1,double y1,double x2,double y2);
@@ -31,16 +42,11 @@ void DrawLine(xdrawable &w,double x1,double y1,double x2,double y2);
 const bool plan_print = false;
 const double out_of_obs_dot = 0.40; // 0.1; // 0.7071;
 
-double sdrand48()
-{
-  return(2*drand48()-1);
-}
-
 state path_planner::random_state()
 {
   state s;
 
-  s.pos.set((FIELD_LENGTH_H+GOAL_DEPTH)*sdrand48(),FIELD_WIDTH_H*sdrand48());
+  s.pos.set((FIELD_LENGTH_H+GOAL_DEPTH)*sdrand(),FIELD_WIDTH_H*sdrand());
   // s.vel.set(0,0);
   s.parent = NULL;
 
@@ -62,6 +68,26 @@ void path_planner::init(int _max_nodes,int _num_waypoints,
   waypoint_target_prob = _waypoint_target_prob;
   step_size = _step_size;
 
+  CR_SETUP(robot, PLAN_REUSE, CR_INT);
+  CR_SETUP(robot, PLAN_REUSE_GOAL_DIST, CR_DOUBLE);
+  CR_SETUP(robot, PLAN_REPAIR_TRIES, CR_INT);
+  CR_SETUP(robot, PLAN_KINO_STEP, CR_DOUBLE);
+  CR_SETUP(robot, PLAN_KINO_HORIZON, CR_DOUBLE);
+
+  rng[0] = 0x330E;
+  rng[1] = lrand48();
+  rng[2] = lrand48();
+  req_pending = false;
+  req_kino = false;
+
+  kino.init(ST_MAX_NODES,_goal_target_prob,
+            DVAR(PLAN_KINO_STEP),DVAR(PLAN_KINO_HORIZON));
+
+  path_len = 0;
+  last_mode = PLAN_DIRECT;
+  last_ttc = -1;
+  waypoint_targets = waypoint_hits = 0;
+
   for(i=0; i<num_waypoints; i++){
     waypoint[i] = random_state();
   }
@@ -103,7 +129,7 @@ state *path_planner::add_node(state n,state *parent)
 
 state path_planner::choose_target(int &targ)
 {
-  double p = drand48();
+  double p = drand();
   int i;
 
   if(p < goal_target_prob){
@@ -111,7 +137,7 @@ state path_planner::choose_target(int &targ)
     return(goal);
   }else if(p < goal_target_prob+waypoint_target_prob){
     targ = 1;
-    i = lrand48() % num_waypoints;
+    i = lrand() % num_waypoints;
     return(waypoint[i]);
   }else{
     targ = 2;
@@ -164,6 +190,7 @@ int path_planner::extend(state *s,state target)
 
   n.pos = s->pos + step;
   // n.vel = s->vel;
+  time_from(n,*s);
 
   if(!obs->check(*s,id)){
     f  = obs->repulse(*s);
@@ -176,7 +203,7 @@ int path_planner::extend(state *s,state target)
       return(num);
     }
   }else if(!obs->check(n,id)){
-    if(obs->obs[id].type == OBS_CIRCLE){
+    if(id>=0 && obs->obs[id].type == OBS_CIRCLE){
       // find tangent angle
       p = obs->obs[id].pos;
       r = max(obs->obs[id].rad.x,obs->obs[id].rad.y);
@@ -198,8 +225,188 @@ int path_planner::extend(state *s,state target)
   return(num);
 }
 
+// Times s as reached in a straight line from from, at the speed the
+// obstacles are swept at.  Times are only used when sweeping.
+void path_planner::time_from(state &s,state &from)
+{
+  float speed = obs->get_sweep_speed();
+  s.t = from.t + ((speed > 0)? distance(from,s) / speed : 0.0);
+}
+
+// Checks the straight leg s0->s1 with s1 timed from s0, rather than by
+// the route it was first reached along.
+bool path_planner::check_leg(state &s0,state s1)
+{
+  time_from(s1,s0);
+  return(obs->check(s0,s1));
+}
+
+bool path_planner::check_leg(state &s0,state s1,int &id)
+{
+  time_from(s1,s0);
+  return(obs->check(s0,s1,id));
+}
+
+bool path_planner::insert_path(int i,state s)
+{
+  int j;
+
+  if(path_len >= MAX_PATH) return(false);
+
+  for(j=path_len; j>i; j--) path[j] = path[j-1];
+  s.parent = NULL;
+  path[i] = s;
+  path_len++;
+
+  return(true);
+}
+
+// Looks for a single waypoint around the blocked leg s0->s1 that has a
+// clear line to both ends, trying waypoints from the cache as often as
+// the RRT would.
+bool path_planner::repair(state &s0,state &s1,state &detour)
+{
+  vector2f m,dir,perp;
+  double len,spread;
+  int i;
+
+  m = (s0.pos + s1.pos) * 0.5;
+  dir = s1.pos - s0.pos;
+  len = dir.length();
+  dir = (len > 0)? dir * (1.0/len) : vector2f(1,0);
+  perp = dir.perp();
+  spread = len/2 + 300;
+
+  detour = s0;
+  for(i=0; i<IVAR(PLAN_REPAIR_TRIES); i++){
+    if(num_waypoints>0 && drand()<waypoint_target_prob){
+      detour = waypoint[lrand() % num_waypoints];
+    }else{
+      detour.pos = m + dir*(sdrand()*len/2) + perp*(sdrand()*spread);
+    }
+
+    time_from(detour,s0);
+    if(obs->check(detour) &&
+       obs->check(s0,detour) && check_leg(detour,s1)) return(true);
+  }
+
+  return(false);
+}
+
+// Tries to carry on along the last path.  Waypoints the robot can skip
+// straight past are dropped, and each leg that is now blocked gets a
+// local detour.  Sets target and obs_id as the RRT would, or returns
+// false if the path has to be planned again.
+bool path_planner::reuse(state &initial,state &target,int &obs_id)
+{
+  state detour;
+  int i,k;
+  bool repaired;
+
+  if(!IVAR(PLAN_REUSE) || path_len<1) return(false);
+  if(Vector::distance(path[path_len-1].pos,goal.pos) >
+     DVAR(PLAN_REUSE_GOAL_DIST)) return(false);
+  if(!obs->check(initial)) return(false);
+
+  // follow the goal as it moves
+  path[path_len-1] = goal;
+  path[path_len-1].parent = NULL;
+  repaired = false;
+
+  // furthest waypoint in sight, which is where we head
+  k = path_len - 1;
+  while(k>=0 && !check_leg(initial,path[k],obs_id)) k--;
+
+  if(k < 0){
+    if(!repair(initial,path[0],detour) || !insert_path(0,detour)){
+      return(false);
+    }
+    k = 0;
+    repaired = true;
+  }
+
+  // drop the waypoints we've passed
+  if(k > 0){
+    for(i=k; i<path_len; i++) path[i-k] = path[i];
+    path_len -= k;
+  }
+
+  // the rest of the path must still be clear
+  time_from(path[0],initial);
+  for(i=0; i+1<path_len; i++){
+    time_from(path[i+1],path[i]);
+    if(obs->check(path[i],path[i+1])) continue;
+    if(!repair(path[i],path[i+1],detour) || !insert_path(i+1,detour)){
+      return(false);
+    }
+    i++;
+    repaired = true;
+  }
+
+  target = path[0];
+  last_mode = repaired? PLAN_REPAIRED : PLAN_REUSED;
+  return(true);
+}
+
+// Keeps the RRT's path to nearest_goal for reuse, if it reached the
+// goal.  Each node is kept only if the next one can't be seen from the
+// last one kept, so the path is short and cheap to check later.
+void path_planner::save_path(state &initial,state *nearest_goal)
+{
+  state *chain[MAX_NODES];
+  state *anchor,*p;
+  int n,j;
+
+  path_len = 0;
+  if(!nearest_goal || distance(*nearest_goal,goal)>=NEAR) return;
+
+  n = 0;
+  for(p=nearest_goal; p!=NULL && p->parent!=NULL; p=p->parent){
+    chain[n++] = p;
+  }
+
+  anchor = &initial;
+  for(j=n-1; j>=0; j--){
+    if(j>0 && check_leg(*anchor,*chain[j-1])) continue;
+    if(!insert_path(path_len,*chain[j])){
+      path_len = 0;
+      return;
+    }
+    anchor = chain[j];
+  }
+
+  if(path_len > 0){
+    path[path_len-1] = goal;
+    path[path_len-1].parent = NULL;
+  }
+}
+
 state path_planner::plan(obstacles *_obs,int obs_mask,
-                         state initial,state _goal,int &obs_id)
+                         state initial,state _goal,int &obs_id,
+                         double deadline)
+{
+  state target;
+  int id;
+
+  goal = _goal;
+  obs = _obs;
+  obs->set_mask(obs_mask);
+  initial.t = 0;
+
+  target = plan_path(initial,obs_id,deadline);
+
+  // what heading for the target now runs into
+  last_ttc = -1;
+  if(obs->get_sweep_speed() > 0){
+    time_from(target,initial);
+    if(target.t > 0) last_ttc = obs->collision_time(initial,target,id);
+  }
+
+  return(target);
+}
+
+// plan() for the goal and obstacles it has set up
+state path_planner::plan_path(state initial,int &obs_id,double deadline)
 {
   state target,*nearest,*nearest_goal,*p,*head;
   vector2f f;
@@ -209,12 +416,16 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
   bool ok;
   bool inobs;
 
-  goal = _goal;
-  obs = _obs;
-  obs->set_mask(obs_mask);
   inobs = false;
+  time_from(goal,initial);
 
   tree.clear();
+  num_nodes = 0;
+
+  last_iterations = 0;
+  last_dist = 0.0;
+  last_slack = (deadline > 0)? deadline - timer::now() : 0.0;
+  last_mode = PLAN_DIRECT;
 
   // check for small trivial plan
   d = Vector::distance(initial.pos,goal.pos);
@@ -224,16 +435,21 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
     s = 1.0;
     do{
       target.pos = initial.pos*(1-s) + goal.pos*s;
+      time_from(target,initial);
       ok = obs->check(initial,target);
       s -= 0.1;
     }while(s>0 && !ok);
 
+    path_len = 0;
     return(target);
   }
 
   if(obs->check(initial,goal)){
     if(plan_print) printf("  PP: no obs\n");
     // no obstacles in the way
+    path[0] = goal;
+    path[0].parent = NULL;
+    path_len = 1;
     return(goal);
   /*
   }else if(!obs->check(initial)){
@@ -255,7 +471,12 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
     }
     return(target);
   */
+  }else if(reuse(initial,target,obs_id)){
+    if(plan_print) printf("  PP: reused %d waypoints\n",path_len);
+    return(target);
   }else{
+    last_mode = PLAN_FULL;
+
     if(plan_print){
       printf("  PP: plan(%f,%f)->(%f,%f)\n",
              V2COMP(initial.pos),V2COMP(goal.pos));
@@ -270,7 +491,12 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
     while(i<iter_limit && num_nodes<max_nodes && d>NEAR){
       target = choose_target(targ_type);
       nearest = (targ_type == 0)? nearest_goal : find_nearest(target);
-      extend(nearest,target);
+      if(targ_type == 1){
+        waypoint_targets++;
+        if(extend(nearest,target) > 0) waypoint_hits++;
+      }else{
+        extend(nearest,target);
+      }
 
       nd = distance(node[num_nodes-1],goal);
       if(nd < d){
@@ -278,14 +504,23 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
         d = nd;
       }
       i++;
+
+      // out of time, go with the best so far
+      if(deadline>0 && i%PLAN_DEADLINE_CHECK==0 && timer::now()>deadline){
+        break;
+      }
     }
 
+    last_iterations = i;
+    last_dist = d;
+    if(deadline > 0) last_slack = deadline - timer::now();
+
     inobs = !obs->check(initial);
 
     // trace back up plan to find simple path
     p = nearest_goal;
     if(!inobs){
-      while(p!=NULL && !obs->check(initial,*p,obs_id)) p = p->parent;
+      while(p!=NULL && !check_leg(initial,*p,obs_id)) p = p->parent;
     }else{
       f = obs->repulse(initial);
 
@@ -306,6 +541,12 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
     }
     head = p;
 
+    if(inobs){
+      path_len = 0;
+    }else{
+      save_path(initial,nearest_goal);
+    }
+
     if(head){
       target = *head;
     }else{
@@ -331,17 +572,17 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
 
     // put in waypoint cache if solution
     if(num_waypoints > 0){
-      if(p!=NULL && ((d < NEAR) || drand48()<0.1)){
+      if(p!=NULL && ((d < NEAR) || drand()<0.1)){
         p = nearest_goal;
         while(p != NULL){
-          i = lrand48()%num_waypoints;
+          i = lrand()%num_waypoints;
           waypoint[i] = *p;
           waypoint[i].parent = NULL;
           if(p == head) break;
           p = p->parent;
         }
       }else{
-        i = lrand48()%num_waypoints;
+        i = lrand()%num_waypoints;
         waypoint[i] = random_state();
       }
     }
@@ -349,3 +590,306 @@ state path_planner::plan(obstacles *_obs,int obs_mask,
     return(target);
   }
 }
+
+state path_planner::plan_kino(obstacles *_obs,int obs_mask,
+                              state initial,vector2f vel,state _goal,
+                              double accel,double speed,double lookahead,
+                              double deadline)
+{
+  st_state s;
+  state target;
+
+  kino.set_limits(accel,speed);
+  s = kino.plan(_obs,obs_mask,initial.pos,vel,_goal.pos,lookahead,deadline);
+
+  last_iterations = kino.last_iterations;
+  last_slack = kino.last_slack;
+  last_dist = kino.last_dist;
+  last_mode = PLAN_KINO;
+  last_ttc = -1;
+
+  // the last path can't be reused by plan() after this one
+  path_len = 0;
+
+  target = initial;
+  target.pos = s.pos;
+  result_vel = s.vel;
+
+  return(target);
+}
+
+double path_planner::path_length(state &initial)
+{
+  double l;
+  int i;
+
+  if(path_len < 1) return(-1);
+
+  l = distance(initial,path[0]);
+  for(i=1; i<path_len; i++) l += distance(path[i-1],path[i]);
+
+  return(l);
+}
+
+void path_planner::request(obstacles &_obs,int obs_mask,
+                           state initial,state _goal)
+{
+  req_obs = _obs;
+  req_mask = obs_mask;
+  req_initial = initial;
+  req_goal = _goal;
+  req_deadline = 0.0;
+  req_kino = false;
+  req_pending = true;
+}
+
+void path_planner::request_kino(obstacles &_obs,int obs_mask,
+                                state initial,vector2f vel,state _goal,
+                                double accel,double speed,double lookahead)
+{
+  request(_obs,obs_mask,initial,_goal);
+
+  req_kino = true;
+  req_vel = vel;
+  req_accel = accel;
+  req_speed = speed;
+  req_lookahead = lookahead;
+}
+
+void path_planner::solve()
+{
+  result_obs_id = -1;
+  if(req_kino){
+    result = plan_kino(&req_obs,req_mask,req_initial,req_vel,req_goal,
+                       req_accel,req_speed,req_lookahead,req_deadline);
+  }else{
+    result = plan(&req_obs,req_mask,req_initial,req_goal,result_obs_id,
+                  req_deadline);
+  }
+  req_pending = false;
+}
+
+//====================================================================//
+//    Plan scenarios
+//====================================================================//
+
+void plan_scenario::write(FILE *out)
+{
+  fprintf(out,"scenario %d\n",robot);
+  fprintf(out,"initial %.1f %.1f %.1f %.1f\n",
+          V2COMP(initial.pos),V2COMP(vel));
+  fprintf(out,"goal %.1f %.1f\n",V2COMP(goal.pos));
+  fprintf(out,"mask %d\n",mask);
+  obs.write(out);
+  fprintf(out,"end\n");
+}
+
+bool plan_scenario::read(FILE *in,distance_field &f)
+{
+  float x,y,vx,vy,gx,gy;
+  char word[16];
+
+  if(fscanf(in," scenario %d",&robot) != 1) return(false);
+  if(fscanf(in," initial %f %f %f %f",&x,&y,&vx,&vy) != 4) return(false);
+  if(fscanf(in," goal %f %f",&gx,&gy) != 2) return(false);
+  if(fscanf(in," mask %d",&mask) != 1) return(false);
+  if(!obs.read(in,f)) return(false);
+  if(fscanf(in," %15s",word)!=1 || strcmp(word,"end")!=0) return(false);
+
+  mzero(initial);
+  mzero(goal);
+  initial.pos.set(x,y);
+  goal.pos.set(gx,gy);
+  vel.set(vx,vy);
+
+  return(true);
+}
+
+//====================================================================//
+//    Plan budget
+//====================================================================//
+
+plan_budget::plan_budget()
+{
+  int i,j;
+
+  CR_SETUP(robot, PLAN_FAR_WEIGHT, CR_DOUBLE);
+
+  frame_end = 0.0;
+  pending = planned = 0;
+
+  for(i=0; i<MAX_TEAM_ROBOTS; i++){
+    weight[i] = 1.0;
+    iterations[i] = 0;
+    slack[i] = 0.0;
+
+    for(j=0; j<PLAN_MODES; j++) mode_count[i][j] = 0;
+    waypoint_targets[i] = waypoint_hits[i] = 0;
+  }
+}
+
+void plan_budget::start_frame(double budget)
+{
+  // expect the robots that planned last frame to plan again
+  pending = planned;
+  planned = 0;
+
+  frame_end = (budget > 0)? timer::now() + budget : 0.0;
+}
+
+double plan_budget::deadline(int robot,int parallel)
+{
+  double now,w,f;
+  int i;
+
+  if(frame_end <= 0) return(0.0);
+
+  now = timer::now();
+  if(now >= frame_end) return(now);
+
+  w = weight[robot];
+  for(i=0; i<MAX_TEAM_ROBOTS; i++){
+    if(i!=robot && (pending & (1 << i))) w += weight[i];
+  }
+
+  f = parallel * weight[robot] / w;
+  if(f > 1.0) f = 1.0;
+
+  return(now + (frame_end - now) * f);
+}
+
+void plan_budget::finished(int robot,path_planner &p)
+{
+  pending &= ~(1 << robot);
+  planned |= 1 << robot;
+
+  iterations[robot] = p.last_iterations;
+  slack[robot] = p.last_slack;
+
+  mode_count[robot][p.last_mode]++;
+  waypoint_targets[robot] = p.waypoint_targets;
+  waypoint_hits[robot] = p.waypoint_hits;
+
+  // robots still short of their goal get more of the next frame
+  weight[robot] = (p.last_dist > NEAR)? DVAR(PLAN_FAR_WEIGHT) : 1.0;
+}
+
+void plan_budget::print(FILE *out)
+{
+  int i;
+
+  fprintf(out,"Plan budget:");
+  for(i=0; i<MAX_TEAM_ROBOTS; i++){
+    if(!(planned & (1 << i))) continue;
+    fprintf(out,"  %d: %3d its %5.2fms",i,iterations[i],slack[i]*1000);
+  }
+  fprintf(out,"\n");
+
+  // how often plans were reused, and the waypoint cache hit rate
+  fprintf(out,"Plan reuse (direct/reused/repaired/full/kino, "
+          "waypoint hits):\n");
+  for(i=0; i<MAX_TEAM_ROBOTS; i++){
+    if(!(planned & (1 << i))) continue;
+    fprintf(out,"  %d: %d/%d/%d/%d/%d",i,
+            mode_count[i][PLAN_DIRECT],mode_count[i][PLAN_REUSED],
+            mode_count[i][PLAN_REPAIRED],mode_count[i][PLAN_FULL],
+            mode_count[i][PLAN_KINO]);
+    if(waypoint_targets[i] > 0){
+      fprintf(out,", %4.1f%%",100.0*waypoint_hits[i]/waypoint_targets[i]);
+    }
+    fprintf(out,"\n");
+  }
+}
+
+//====================================================================//
+//    Plan pool
+//====================================================================//
+
+plan_pool::plan_pool()
+{
+  nworkers = 0;
+  job = NULL;
+  job_arg = NULL;
+  njobs = next = ndone = 0;
+  generation = 0;
+
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&work_ready,NULL);
+  pthread_cond_init(&work_done,NULL);
+}
+
+void plan_pool::start(int threads)
+{
+  threads = bound(threads,1,MAX_PLAN_THREADS);
+
+  while(nworkers < threads-1){
+    if(pthread_create(&workers[nworkers],NULL,worker_main,this) != 0){
+      fprintf(stderr,"plan_pool: Cannot create worker thread.\n");
+      break;
+    }
+    pthread_detach(workers[nworkers]);
+    nworkers++;
+  }
+}
+
+// Runs jobs until none are left.  Called with the lock held.
+void plan_pool::work()
+{
+  int i;
+
+  while(next < njobs){
+    i = next++;
+
+    pthread_mutex_unlock(&lock);
+    job(job_arg,i);
+    pthread_mutex_lock(&lock);
+
+    if(++ndone == njobs) pthread_cond_signal(&work_done);
+  }
+}
+
+void *plan_pool::worker_main(void *arg)
+{
+  plan_pool *pool = (plan_pool*)arg;
+  int gen;
+
+  pthread_mutex_lock(&pool->lock);
+  gen = pool->generation;
+
+  while(true){
+    while(pool->generation == gen){
+      pthread_cond_wait(&pool->work_ready,&pool->lock);
+    }
+    gen = pool->generation;
+    pool->work();
+  }
+
+  return(NULL);
+}
+
+static void solve_job(void *arg,int i)
+{
+  ((path_planner**)arg)[i]->solve();
+}
+
+void plan_pool::solve(path_planner **p,int n)
+{
+  run(solve_job,p,n);
+}
+
+void plan_pool::run(void (*fn)(void *arg,int i),void *arg,int n)
+{
+  pthread_mutex_lock(&lock);
+
+  job = fn;
+  job_arg = arg;
+  njobs = n;
+  next = ndone = 0;
+  generation++;
+  pthread_cond_broadcast(&work_ready);
+
+  work();
+  while(ndone < njobs) pthread_cond_wait(&work_done,&lock);
+
+  pthread_mutex_unlock(&lock);
+}
@@ -17,13 +17,33 @@
 #ifndef __PATH_PLANNER_H__
 #define __PATH_PLANNER_H__
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "constants.h"
 #include "obstacle.h"
 #include "kdtree.h"
+#include "st_planner.h"
 
 #define MAX_NODES  400
 #define MAX_WAYPTS 100
 #define NEAR 100
 
+// plan() checks its deadline every this many iterations
+#define PLAN_DEADLINE_CHECK 8
+
+// longest path kept between frames for reuse
+#define MAX_PATH 32
+
+// how plan() found its path
+#define PLAN_DIRECT   0  // trivial, short or no obstacles in the way
+#define PLAN_REUSED   1  // last frame's path was still clear
+#define PLAN_REPAIRED 2  // last frame's path with blocked legs detoured
+#define PLAN_FULL     3  // a new RRT
+#define PLAN_KINO     4  // space-time plan by st_planner
+#define PLAN_MODES    5
+
 class path_planner{
   state node[MAX_NODES];
   state waypoint[MAX_WAYPTS];
@@ -41,8 +61,62 @@ class path_planner{
   double step_size;
 
   obstacles *obs;
+
+  // The last path found, as shortcut waypoints from just past the
+  // robot to the goal, for reuse by the next plan().
+  state path[MAX_PATH];
+  int path_len;
+
+  st_planner kino;
+
+  // this planner's own random state, so planners can run in parallel
+  unsigned short rng[3];
+  double drand()  {return(erand48(rng));}
+  double sdrand() {return(2*erand48(rng)-1);}
+  long lrand()    {return(nrand48(rng));}
 public:
   int robot_id;
+
+  // A plan posted by request() and run by solve(), so the plans of
+  // several robots can be solved at once by a plan_pool.
+  obstacles req_obs;
+  state req_initial,req_goal;
+  int req_mask;
+  double req_deadline;
+  bool req_pending;
+
+  // set for request_kino()
+  bool req_kino;
+  vector2f req_vel;
+  double req_accel,req_speed,req_lookahead;
+
+  state result;
+  int result_obs_id;
+  vector2f result_vel; // of the last plan_kino() target
+
+  // results of the last plan()
+  int last_iterations;
+  double last_slack; // time left before the deadline (<0 if overrun)
+  double last_dist;  // distance from the best node found to the goal
+  int last_mode;     // PLAN_DIRECT ... PLAN_FULL
+  // When the robot, heading straight for the target at the obstacles'
+  // sweep speed, first touches a moving obstacle, or -1 if it doesn't
+  // (or the obstacles aren't swept, see obstacles::set_sweep()).
+  double last_ttc;
+
+  // RRT extensions towards cached waypoints, and those that added a
+  // node, since init()
+  int waypoint_targets,waypoint_hits;
+protected:
+  void time_from(state &s,state &from);
+  bool check_leg(state &s0,state s1);
+  bool check_leg(state &s0,state s1,int &id);
+  state plan_path(state initial,int &obs_id,double deadline);
+
+  bool insert_path(int i,state s);
+  bool repair(state &s0,state &s1,state &detour);
+  bool reuse(state &initial,state &target,int &obs_id);
+  void save_path(state &initial,state *nearest_goal);
 public:
   void init(int _max_nodes,int _num_waypoints,
             double _goal_target_prob,double _waypoint_target_prob,
@@ -55,8 +129,111 @@ public:
   state *find_nearest(state target);
 
   int extend(state *s,state target);
+  // If deadline is nonzero (a timer::now() time), planning stops there
+  // and the best path found so far is used.
   state plan(obstacles *_obs,int obs_mask,
-             state initial,state _goal,int &obs_id);
+             state initial,state _goal,int &obs_id,
+             double deadline = 0.0);
+
+  // A space-time plan for an omni robot moving at vel, with its
+  // acceleration and speed limits.  The target returned is lookahead
+  // seconds along the plan, and result_vel is its velocity.
+  state plan_kino(obstacles *_obs,int obs_mask,
+                  state initial,vector2f vel,state _goal,
+                  double accel,double speed,double lookahead,
+                  double deadline = 0.0);
+
+  // size of the tree grown by the last plan() (0 if it needed none)
+  int nodes() {return(num_nodes);}
+  // length of the last plan()'s path from initial, if it reached the
+  // goal, or else -1
+  double path_length(state &initial);
+
+  void request(obstacles &_obs,int obs_mask,state initial,state _goal);
+  void request_kino(obstacles &_obs,int obs_mask,
+                    state initial,vector2f vel,state _goal,
+                    double accel,double speed,double lookahead);
+  void solve();
+};
+
+// A planning problem as nav_to_point posed it, kept as text so it can
+// be captured in play and replayed offline (see logging/plan_bench).
+struct plan_scenario{
+  int robot;
+  state initial,goal;
+  vector2f vel;  // the robot's velocity
+  int mask;
+  obstacles obs;
+
+  void write(FILE *out);
+  bool read(FILE *in,distance_field &f);
+};
+
+// Shares a per-frame time budget for planning between the robots.
+// Each robot gets the time left in the frame split between it and the
+// robots that planned last frame but haven't yet this frame, weighted
+// towards robots whose last plan ended far from the goal.  Time that
+// a robot doesn't use is passed on to those planning after it.
+class plan_budget{
+  double frame_end;
+  int pending;  // robots yet to plan this frame
+  int planned;  // robots that have planned this frame
+
+  double weight[MAX_TEAM_ROBOTS];
+  int iterations[MAX_TEAM_ROBOTS];
+  double slack[MAX_TEAM_ROBOTS];
+
+  // plans of each PLAN_ mode, and waypoint cache use
+  int mode_count[MAX_TEAM_ROBOTS][PLAN_MODES];
+  int waypoint_targets[MAX_TEAM_ROBOTS],waypoint_hits[MAX_TEAM_ROBOTS];
+public:
+  plan_budget();
+
+  // budget in seconds, zero for no deadlines
+  void start_frame(double budget);
+
+  // Robots that will plan this frame even though they didn't last.
+  void expect(int robot) {pending |= 1 << robot;}
+
+  // With parallel > 1 that many robots plan at once, each getting a
+  // correspondingly larger share.
+  double deadline(int robot,int parallel = 1);
+  void finished(int robot,path_planner &p);
+
+  void print(FILE *out);
+};
+
+#define MAX_PLAN_THREADS 8
+
+// Persistent threads that solve the pending requests of several
+// planners at once.  The thread calling solve() works too, so a pool
+// of n threads has n-1 workers.  run() hands the same threads other
+// work split into independent jobs.
+class plan_pool{
+  pthread_t workers[MAX_PLAN_THREADS];
+  int nworkers;
+
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready,work_done;
+
+  void (*job)(void *arg,int i);
+  void *job_arg;
+  int njobs,next,ndone;
+  int generation;
+
+  static void *worker_main(void *arg);
+  void work();
+public:
+  plan_pool();
+
+  void start(int threads);
+  int threads() {return(nworkers+1);}
+
+  // returns once all n planners are solved
+  void solve(path_planner **p,int n);
+
+  // calls fn(arg,i) for i in [0,n) and returns once all have returned
+  void run(void (*fn)(void *arg,int i),void *arg,int n);
 };
 
 #endif /*__PATH_PLANNER_H__*/
@@ -30,6 +30,41 @@
 #include "goalie.h"
 #include "ball_tactics.h"
 
+WorldPredicateTable world_predicates;
+
+int WorldPredicateTable::bit(WorldPredicate p, double argument)
+{
+  for(uint i=0; i<entries.size(); i++)
+    if (entries[i].predicate == p && entries[i].argument == argument)
+      return i;
+
+  if (entries.size() >= PREDICATE_MAX) return -1;
+
+  Entry e;
+  e.predicate = p;
+  e.argument = argument;
+  entries.push_back(e);
+
+  // evaluate it next time
+  bits_world = NULL;
+
+  return entries.size() - 1;
+}
+
+const PredicateBits &WorldPredicateTable::eval(World &world)
+{
+  if (bits_world == &world && bits_time == world.time) return bits;
+
+  bits.clear();
+  for(uint i=0; i<entries.size(); i++)
+    if ((entries[i].predicate)(world, entries[i].argument)) bits.set(i);
+
+  bits_world = &world;
+  bits_time = world.time;
+
+  return bits;
+}
+
 PlayRole::PlayRole(Tactic *t, ...)
 {
   va_list ap;
@@ -477,6 +512,30 @@ WorldPredicateConjunct &PlayAscii::parsePredicate(const char *string, int &n)
   return pred;
 }
 
+// The opponent the model has seen move fastest, by the speed it's
+// under 90% of the time so a single dash doesn't count for much.
+// Those the model hasn't seen yet go by how fast they're moving now.
+int PlayAscii::orole_fastest(World &world, bool candidates[])
+{
+  int best_id = -1;
+  double best = 0.0;
+
+  if (world.orole_goalie >= 0) candidates[world.orole_goalie] = false;
+
+  for(int i=0; i<world.n_opponents; i++) {
+    if (!candidates[i]) continue;
+
+    double s = world.modeller.speed_quantile(i, 0.9);
+    if (s < 0.0) s = world.opponent_velocity(i).length();
+
+    if (best_id < 0 || s > best) {
+      best_id = i; best = s;
+    }
+  }
+
+  return best_id;
+}
+
 OpponentRole PlayAscii::parseORole(const char *string, int &n)
 {
   OpponentRole o = NULL;
@@ -494,6 +553,7 @@ OpponentRole PlayAscii::parseORole(const char *string, int &n)
   else if (strcmp(word, "closest_to_shot") == 0) o = &orole_closest_to_ball;
   else if (strcmp(word, "best_pass") == 0) o = &orole_closest_to_ball;
   else if (strcmp(word, "goalie") == 0) o = &orole_goalie;
+  else if (strcmp(word, "fastest") == 0) o = &orole_fastest;
   else {
     fprintf(stderr, "ERROR: PlayAscii could not parse opponent role, %s... ignoring.\n", word);
     printErrorLine(string, n - 1);
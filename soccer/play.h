@@ -79,14 +79,76 @@ public:
 
 typedef bool (*WorldPredicate)(World &world, double argument);
 
+// One bit per predicate in the WorldPredicateTable.
+#define PREDICATE_WORDS 4
+#define PREDICATE_MAX (PREDICATE_WORDS * 32)
+
+struct PredicateBits {
+  unsigned int w[PREDICATE_WORDS];
+
+  PredicateBits() { clear(); }
+
+  void clear() { 
+    for(int i=0; i<PREDICATE_WORDS; i++) w[i] = 0; }
+  void set(int b) { w[b >> 5] |= 1u << (b & 31); }
+
+  // Whether all of the bits in all are set and none of those in none.
+  bool match(const PredicateBits &all, const PredicateBits &none) const {
+    unsigned int miss = 0;
+    for(int i=0; i<PREDICATE_WORDS; i++)
+      miss |= ((w[i] & all.w[i]) ^ all.w[i]) | (w[i] & none.w[i]);
+    return miss == 0; }
+};
+
+// Every distinct predicate and argument the plays use, each given a
+// bit.  They're all evaluated together at most once a frame, so plays
+// sharing a predicate don't evaluate it again.
+class WorldPredicateTable {
+private:
+  struct Entry {
+    WorldPredicate predicate;
+    double argument;
+  };
+
+  vector<Entry> entries;
+
+  PredicateBits bits;
+  World *bits_world;
+  double bits_time;
+
+public:
+  WorldPredicateTable() { bits_world = NULL; bits_time = 0; }
+
+  // Returns the predicate's bit, adding it if it's new, or -1 if the
+  // table is full.
+  int bit(WorldPredicate p, double argument);
+
+  // The bits of the predicates that hold in the world.
+  const PredicateBits &eval(World &world);
+
+  int size() { return entries.size(); }
+};
+
+extern WorldPredicateTable world_predicates;
+
 class WorldPredicateConjunct {
 private:
   vector<WorldPredicate> predicate;
   vector<bool> predicate_negated;
   vector<double> predicate_argument;
+
+  // The bits that must be set and clear in world_predicates for the
+  // conjunct to hold, unless the table filled up.
+  PredicateBits must_hold, must_fail;
+  bool compiled;
   
 public:
+  WorldPredicateConjunct() { compiled = true; }
+
   bool eval(World &world) {
+    if (compiled) 
+      return world_predicates.eval(world).match(must_hold, must_fail);
+
     for(uint i=0; i<predicate.size(); i++)
       if (! (predicate_negated[i] ^ 
 	     (predicate[i])(world, predicate_argument[i])) ) return false;
@@ -95,10 +157,16 @@ public:
   void add(WorldPredicate p, bool negated, double argument) {
     predicate.push_back(p);
     predicate_negated.push_back(negated);
-    predicate_argument.push_back(argument); }
+    predicate_argument.push_back(argument); 
+
+    int b = world_predicates.bit(p, argument);
+    if (b < 0) compiled = false;
+    else if (negated) must_fail.set(b);
+    else must_hold.set(b); }
 
   void clear() {
-    predicate.clear(); predicate_negated.clear(); predicate_argument.clear(); }
+    predicate.clear(); predicate_negated.clear(); predicate_argument.clear(); 
+    must_hold.clear(); must_fail.clear(); compiled = true; }
 };
 
 //
@@ -207,6 +275,7 @@ private:
   static int orole_closest_to_ball(World &world, bool candidates[]);
   static int orole_closest_to_shot(World &world, bool candidates[]);
   static int orole_best_pass(World &world, bool candidates[]);
+  static int orole_fastest(World &world, bool candidates[]);
 
   //
   // Parsing Methods
@@ -0,0 +1,364 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include <configreader.h>
+
+#include "geometry.h"
+#include "constants.h"
+
+#include "soccer.h"
+#include "world.h"
+#include "evaluation.h"
+#include "quality_grid.h"
+
+// Passes are aimed at this far either side of the receiver, as in the
+// position_for_pass tactic.
+#define QG_PASS_WIDTH 30.0 // mm
+
+// Moved opponents are checked against the shot or pass cone stretched
+// this far past its far end, and with their radius grown by
+// QG_MARGIN, since aim() judges what's in range by angle.
+#define QG_BEYOND 200.0 // mm
+#define QG_MARGIN 20.0  // mm
+
+// most lines draw() sends
+#define QG_DRAW_LINES 400.0
+
+static bool cr_setup = false;
+CR_DECLARE(QUALITY_GRID);
+CR_DECLARE(QUALITY_GRID_CELL);
+CR_DECLARE(QUALITY_GRID_MOVE);
+CR_DECLARE(QUALITY_GRID_DRAW);
+
+static void cr_setup_do()
+{
+  if (!cr_setup) {
+    CR_SETUP(tactic, QUALITY_GRID, CR_INT);
+    CR_SETUP(tactic, QUALITY_GRID_CELL, CR_DOUBLE);
+    CR_SETUP(tactic, QUALITY_GRID_MOVE, CR_DOUBLE);
+    CR_SETUP(tactic, QUALITY_GRID_DRAW, CR_INT);
+
+    cr_setup = true;
+  }
+}
+
+// Whether a circle overlaps the triangle a,b,c.
+static bool circle_in_triangle(vector2d p,double r,
+			       vector2d a,vector2d b,vector2d c)
+{
+  double s1 = (b - a).cross(p - a);
+  double s2 = (c - b).cross(p - b);
+  double s3 = (a - c).cross(p - c);
+
+  if ((s1 >= 0 && s2 >= 0 && s3 >= 0) || (s1 <= 0 && s2 <= 0 && s3 <= 0))
+    return(true);
+
+  r *= r;
+  return(sqdistance(p,point_on_segment(a,b,p)) < r ||
+	 sqdistance(p,point_on_segment(b,c,p)) < r ||
+	 sqdistance(p,point_on_segment(c,a,p)) < r);
+}
+
+quality_grid::quality_grid()
+{
+  width = height = 0;
+  cell = minx = miny = 0;
+  shot_tol = shot_y = pass_tol = NULL;
+  n_opp = 0;
+  valid = false;
+  n_moved = 0;
+  redo = 0;
+  recomputed = 0;
+}
+
+quality_grid::~quality_grid()
+{
+  delete[](shot_tol);
+  delete[](shot_y);
+  delete[](pass_tol);
+}
+
+void quality_grid::init()
+{
+  cr_setup_do();
+
+  cell = DVAR(QUALITY_GRID_CELL);
+  if (cell < 10.0) cell = 10.0;
+
+  // cell centers from wall to wall
+  width  = (int) ceil(FIELD_LENGTH / cell) + 1;
+  height = (int) ceil(FIELD_WIDTH / cell) + 1;
+  minx = -FIELD_LENGTH_H;
+  miny = -FIELD_WIDTH_H;
+
+  delete[](shot_tol);
+  delete[](shot_y);
+  delete[](pass_tol);
+
+  shot_tol = new float[width * height];
+  shot_y   = new float[width * height];
+  pass_tol = new float[width * height];
+
+  valid = false;
+}
+
+void quality_grid::update(World &world,plan_pool &pool)
+{
+  vector2d p;
+  int n;
+
+  recomputed = 0;
+
+  if (!IVAR(QUALITY_GRID) || !shot_tol) {
+    valid = false;
+    return;
+  }
+
+  double move = DVAR(QUALITY_GRID_MOVE);
+
+  goal_l = world.their_goal_l;
+  goal_r = world.their_goal_r;
+
+  n = world.n_opponents;
+  if (n > MAX_TEAM_ROBOTS) n = MAX_TEAM_ROBOTS;
+
+  n_moved = 0;
+  redo = 0;
+
+  // Opponents are compared with where the cells last saw them, so
+  // creeping a little each frame still adds up to a move.
+  if (!valid || n != n_opp) {
+    redo = QG_SHOT | QG_PASS;
+
+    for(int i=0; i<n; i++) {
+      opp[i] = world.opponent_position(i);
+      radius[i] = ROBOT_DEF_WIDTH_H;
+    }
+    n_opp = n;
+  } else {
+    for(int i=0; i<n; i++) {
+      p = world.opponent_position(i);
+      if (sqdistance(p,opp[i]) <= move * move) continue;
+
+      moved[n_moved++] = opp[i];
+      moved[n_moved++] = p;
+      opp[i] = p;
+    }
+  }
+
+  p = world.ball_position();
+  if (!valid || sqdistance(p,ball) > move * move) {
+    redo |= QG_PASS;
+    ball = p;
+  }
+
+  valid = true;
+
+  if (redo || n_moved) pool.run(row_job,this,height);
+
+  if (IVAR(QUALITY_GRID_DRAW)) draw(IVAR(QUALITY_GRID_DRAW),GDBG_STRATEGY);
+}
+
+void quality_grid::row_job(void *arg,int row)
+{
+  ((quality_grid*)arg)->update_row(row);
+}
+
+// Whether a moved opponent could block some of the shot from p.
+bool quality_grid::affects_shot(vector2d p)
+{
+  vector2d l = goal_l + (goal_l - p).norm(QG_BEYOND);
+  vector2d r = goal_r + (goal_r - p).norm(QG_BEYOND);
+
+  for(int i=0; i<n_moved; i++) {
+    if (circle_in_triangle(moved[i],ROBOT_DEF_WIDTH_H + QG_MARGIN,p,l,r))
+      return(true);
+  }
+
+  return(false);
+}
+
+// Whether a moved opponent could block some of the pass to p.
+bool quality_grid::affects_pass(vector2d p)
+{
+  vector2d far = p + (p - ball).norm(QG_BEYOND);
+
+  for(int i=0; i<n_moved; i++) {
+    if (sqdistance(moved[i],point_on_segment(ball,far,moved[i])) <
+	sq(ROBOT_DEF_WIDTH_H + QG_PASS_WIDTH + QG_MARGIN))
+      return(true);
+  }
+
+  return(false);
+}
+
+void quality_grid::update_row(int row)
+{
+  vector2d p,target,perp;
+  double tol;
+  int k,n = 0;
+
+  for(int col=0; col<width; col++) {
+    k = row * width + col;
+    p.set(minx + col * cell,miny + row * cell);
+
+    if ((redo & QG_SHOT) || affects_shot(p)) {
+      if (!evaluation.aim(n_opp, opp, radius, p, goal_r, goal_l,
+			  (goal_r + goal_l) / 2.0, 0.0, target, tol))
+	tol = 0.0;
+
+      // as the goal posts go edge on
+      if (!(fabs(target.y - goal_l.y) <= fabs(goal_r.y - goal_l.y)))
+	target = (goal_r + goal_l) / 2.0;
+
+      shot_tol[k] = tol;
+      shot_y[k] = target.y;
+      n++;
+    }
+
+    if ((redo & QG_PASS) || affects_pass(p)) {
+      // no pass to where the ball already is
+      tol = 0.0;
+
+      if (sqdistance(p,ball) > sq(QG_PASS_WIDTH)) {
+	perp = (p - ball).perp().norm(QG_PASS_WIDTH);
+
+	if (!evaluation.aim(n_opp, opp, radius, ball, p + perp, p - perp,
+			    p, 0.0, target, tol))
+	  tol = 0.0;
+      }
+
+      pass_tol[k] = tol;
+      n++;
+    }
+  }
+
+  if (n) __sync_fetch_and_add(&recomputed,n);
+}
+
+// The cell below and left of p, and how far p is across it.
+bool quality_grid::cell_at(vector2d p,int &i,double &fx,double &fy)
+{
+  if (!valid) return(false);
+
+  double x = (p.x - minx) / cell;
+  double y = (p.y - miny) / cell;
+
+  // also false for NaN
+  if (!(x >= 0 && y >= 0 && x <= width - 1 && y <= height - 1))
+    return(false);
+
+  int cx = (int) x, cy = (int) y;
+  if (cx > width - 2) cx = width - 2;
+  if (cy > height - 2) cy = height - 2;
+
+  i = cy * width + cx;
+  fx = x - cx;
+  fy = y - cy;
+
+  return(true);
+}
+
+static inline double bilinear(const float *d,int i,int width,
+			      double fx,double fy)
+{
+  double a = d[i] + (d[i + 1] - d[i]) * fx;
+  double b = d[i + width] + (d[i + width + 1] - d[i + width]) * fx;
+
+  return(a + (b - a) * fy);
+}
+
+bool quality_grid::shot(vector2d p,vector2d &target,double &tolerance)
+{
+  double fx,fy;
+  int i;
+
+  if (!cell_at(p,i,fx,fy)) return(false);
+
+  tolerance = bilinear(shot_tol,i,width,fx,fy);
+
+  // The target isn't interpolated: the cells' gaps may be either side
+  // of a blocker, and halfway between them is on it.
+  int k = i, corner[3] = {i + 1, i + width, i + width + 1};
+  for(int c=0; c<3; c++) {
+    if (shot_tol[corner[c]] > shot_tol[k]) k = corner[c];
+  }
+  target.set(goal_l.x,shot_y[k]);
+
+  return(true);
+}
+
+bool quality_grid::pass(vector2d p,double &tolerance)
+{
+  double fx,fy;
+  int i;
+
+  if (!cell_at(p,i,fx,fy)) return(false);
+
+  tolerance = bilinear(pass_tol,i,width,fx,fy);
+
+  return(true);
+}
+
+bool quality_grid::pass_max(vector2d p,double &tolerance)
+{
+  double fx,fy;
+  int i;
+
+  if (!cell_at(p,i,fx,fy)) return(false);
+
+  tolerance = pass_tol[i];
+  if (pass_tol[i + 1] > tolerance) tolerance = pass_tol[i + 1];
+  if (pass_tol[i + width] > tolerance) tolerance = pass_tol[i + width];
+  if (pass_tol[i + width + 1] > tolerance) tolerance = pass_tol[i + width + 1];
+
+  return(true);
+}
+
+void quality_grid::draw(int which,int level)
+{
+  vector2d p,dir;
+  double tol;
+  int k;
+
+  if (!valid) return;
+
+  // every few cells, to fit in the GUI's debug queue
+  int step = (int) ceil(sqrt(width * height / QG_DRAW_LINES));
+
+  for(int row=0; row<height; row+=step) {
+    for(int col=0; col<width; col+=step) {
+      k = row * width + col;
+      p.set(minx + col * cell,miny + row * cell);
+
+      if (which == QG_SHOT) {
+	tol = shot_tol[k];
+	dir = vector2d(goal_l.x,shot_y[k]) - p;
+      } else {
+	tol = pass_tol[k];
+	dir = ball - p;
+      }
+
+      // a full cell for a sixteenth of a circle or more
+      if (tol <= 0.0 || dir.sqlength() < 1.0) continue;
+      if (tol > M_PI_8) tol = M_PI_8;
+
+      gui_debug_line(-1, level, p, p + dir.norm(cell * tol / M_PI_8));
+    }
+  }
+}
@@ -0,0 +1,95 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// How good a place each point of the field is to shoot or receive a
+// pass from, sampled on a grid once a frame: the open angle of a shot
+// at their goal past the opponents, as aim() finds it, and the open
+// angle of a pass to there from the ball.  Cells are only recomputed
+// when an opponent that moved (or the ball, for passes) could change
+// them, and then split across the planning threads.  Lookups
+// interpolate between cell centers.
+
+#ifndef __QUALITY_GRID_H__
+#define __QUALITY_GRID_H__
+
+#include "geometry.h"
+#include "constants.h"
+
+class World;
+class plan_pool;
+
+// recompute flags for a cell
+#define QG_SHOT 1
+#define QG_PASS 2
+
+class quality_grid{
+  int width,height;
+  double cell,minx,miny;
+
+  float *shot_tol; // open angle of the shot (0 if none)
+  float *shot_y;   // where the shot crosses their goal line
+  float *pass_tol; // open angle of a pass from the ball (0 if none)
+
+  // the opponents and ball the cells were last computed for
+  vector2d opp[MAX_TEAM_ROBOTS];
+  double radius[MAX_TEAM_ROBOTS];
+  int n_opp;
+  vector2d ball;
+  bool valid;
+
+  // this update: their goal, and where the opponents that moved were
+  // and are now
+  vector2d goal_l,goal_r;
+  vector2d moved[MAX_TEAM_ROBOTS * 2];
+  int n_moved;
+  int redo; // QG_* flags to recompute in every cell
+
+  int recomputed;
+
+  bool affects_shot(vector2d p);
+  bool affects_pass(vector2d p);
+  void update_row(int row);
+  static void row_job(void *arg,int row);
+  bool cell_at(vector2d p,int &i,double &fx,double &fy);
+public:
+  quality_grid();
+  ~quality_grid();
+
+  void init();
+
+  // Brings the cells up to date with the world, running on pool.
+  void update(World &world,plan_pool &pool);
+
+  // These return false if p is off the grid or the grid is off
+  // (QUALITY_GRID in tactic.cfg), and the caller should use aim().
+  // Otherwise they give what aim() would for OBS_OPPONENTS now.
+  // The shot's target is that of the most open cell around p.
+  bool shot(vector2d p,vector2d &target,double &tolerance);
+  bool pass(vector2d p,double &tolerance);
+
+  // The most open pass of the cells around p, for ruling points out
+  // before calling aim().
+  bool pass_max(vector2d p,double &tolerance);
+
+  // cells recomputed by the last update()
+  int cells_updated() {return(recomputed);}
+
+  // Draws the QG_SHOT or QG_PASS cells, each as a tick pointing at
+  // the target whose length is the open angle.
+  void draw(int which,int level);
+};
+
+#endif /*__QUALITY_GRID_H__*/
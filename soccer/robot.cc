@@ -66,6 +66,8 @@ void Robot::init(int _my_id)
   last_dist_from_target = 0.0;
   last_target_da = 0.0;
   spin_dir = 0;
+  nav_pending.active = false;
+  nav_ttc = -1;
 }
 
 const vector2d own_goal_pos(-FIELD_LENGTH_H-2*BALL_RADIUS,0);
@@ -634,6 +636,7 @@ Status Robot::run(World &world,RobotCommand &cmd,Trajectory &tcmd)
   int n;
 
   omni = (world.teammate_type(my_id) == ROBOT_TYPE_OMNI);
+  nav_pending.active = false;
 
   // If command changed, set initial state
   if(cmd.cmd != last_cmd){
@@ -773,12 +776,36 @@ Status Robot::run(World &world,RobotCommand &cmd)
   Status s;
 
   s = run(world,cmd,tcmd);
+
+  // sent by finishNav() once the plan is solved
+  if(nav_pending.active){
+    nav_pending.offset = tcmd;
+    return(s);
+  }
+
   world.go(my_id,tcmd.vx,tcmd.vy,tcmd.va,
            tcmd.kicker_on,tcmd.dribbler_on);
 
   return(s);
 }
 
+void Robot::finishNav(World &world)
+{
+  path_planner &pp = world.path[my_id];
+  Trajectory &o = nav_pending.offset;
+  Trajectory tcmd;
+
+  if(!nav_pending.active) return;
+  nav_pending.active = false;
+
+  tcmd = nav_from_plan(world,my_id,pp.req_obs,pp.result,pp.result_obs_id,
+                       nav_pending.target_pos,nav_pending.target_vel,
+                       nav_pending.target_angle,nav_pending.type);
+
+  world.go(my_id,tcmd.vx+o.vx,tcmd.vy+o.vy,tcmd.va+o.va,
+           o.kicker_on,o.dribbler_on);
+}
+
 double Robot::time(World &world,RobotCommand &cmd)
 {
   Sensors &s = sensors;
@@ -182,6 +182,21 @@ private:
   bool omni;
   bool state_changed;
 
+  // The rest of a nav_to_point() whose plan was deferred (see
+  // World::collectPlans()).  offset is the command run() computed
+  // around it, to be added on.
+  struct NavPending{
+    bool active;
+    vector2d target_pos,target_vel;
+    double target_angle;
+    GotoPointType type;
+    Trajectory offset;
+  } nav_pending;
+
+  // Time until the path nav_from_plan() is driving runs into a moving
+  // obstacle, for goto_point_omni() to slow down for (-1 if none).
+  double nav_ttc;
+
 public:
   void init(int _my_id);
 
@@ -201,6 +216,7 @@ public:
 
   Status run(World &world,RobotCommand &cmd,Trajectory &tcmd);
   Status run(World &world,RobotCommand &cmd);
+  void finishNav(World &world);
   double time(World &world,RobotCommand &cmd);
 
   // in goto-point.cc
@@ -231,6 +247,10 @@ public:
                           vector2d target_pos, vector2d target_vel,
                           double target_angle,int obs_flags,
 			  GotoPointType type = GotoPointMove);
+  Trajectory nav_from_plan(World &world, int me,
+                           obstacles &obs, ::state target, int obs_id,
+                           vector2d target_pos, vector2d target_vel,
+                           double target_angle, GotoPointType type);
   Trajectory goto_point_speed(World &world, int me,
                               vector2d target_pos,vector2d target_vel,
                               double target_angle,
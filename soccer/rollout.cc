@@ -0,0 +1,304 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include <configreader.h>
+
+#include "geometry.h"
+#include "constants.h"
+#include "util.h"
+#include "timer.h"
+
+#include "world.h"
+#include "world_snapshot.h"
+#include "robot.h"
+#include "rollout.h"
+
+// how fast a kick sends the ball
+#define ROLLOUT_KICK_SPEED 3000.0 // mm/s
+
+// how much speed the ball keeps bouncing off a wall
+#define ROLLOUT_WALL_BOUNCE 0.5
+
+// how often run() looks at the clock
+#define ROLLOUT_CLOCK_STEPS 8
+
+static bool cr_setup = false;
+CR_DECLARE(BALL_FRICTION);
+CR_DECLARE(OMNI_MAX_ACCEL);
+CR_DECLARE(OMNI_MAX_SPEED);
+CR_DECLARE(DIFF_MAX_ACCEL);
+CR_DECLARE(DIFF_MAX_SPEED);
+
+static void cr_setup_do()
+{
+  if (!cr_setup) {
+    CR_SETUP(tracker, BALL_FRICTION, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_ACCEL, CR_DOUBLE);
+    CR_SETUP(motion, OMNI_MAX_SPEED, CR_DOUBLE);
+    CR_SETUP(motion, DIFF_MAX_ACCEL, CR_DOUBLE);
+    CR_SETUP(motion, DIFF_MAX_SPEED, CR_DOUBLE);
+
+    cr_setup = true;
+  }
+}
+
+void play_rollout::set(World &world)
+{
+  n_ours = n_opp = 0;
+
+  set_ball(world.ball_position(),world.ball_velocity());
+
+  for(int i=0; i<world.n_teammates && i<MAX_TEAM_ROBOTS; i++) {
+    set_teammate(i,world.teammate_position(i),world.teammate_velocity(i),
+		 world.teammate_type(i));
+  }
+
+  for(int i=0; i<world.n_opponents && i<MAX_TEAM_ROBOTS; i++)
+    set_opponent(i,world.opponent_position(i),world.opponent_velocity(i));
+}
+
+void play_rollout::set(const WorldSnapshot &s)
+{
+  n_ours = n_opp = 0;
+
+  set_ball(s.ball_position(),s.ball_velocity());
+
+  for(int i=0; i<s.n_teammates && i<MAX_TEAM_ROBOTS; i++) {
+    set_teammate(i,s.teammate_position(i),s.teammate_velocity(i),
+		 s.teammate_type(i));
+  }
+
+  for(int i=0; i<s.n_opponents && i<MAX_TEAM_ROBOTS; i++)
+    set_opponent(i,s.opponent_position(i),s.opponent_velocity(i));
+}
+
+void play_rollout::set_ball(vector2d p,vector2d v)
+{
+  cr_setup_do();
+
+  ball_pos = p;
+  ball_vel = v;
+  decel = DVAR(BALL_FRICTION) * GRAVITY;
+
+  owner = kicker = ROLLOUT_NOBODY;
+  goal = 0;
+  elapsed = 0.0;
+  finished = false;
+}
+
+void play_rollout::set_teammate(int id,vector2d p,vector2d v,int type)
+{
+  mover &m = ours[id];
+
+  cr_setup_do();
+
+  m.pos = m.target = p;
+  m.vel = v;
+  m.chase = m.kicks = m.carries = false;
+
+  if (type == ROBOT_TYPE_DIFF) {
+    m.accel = VDVAR(DIFF_MAX_ACCEL)[Robot::GotoPointMove];
+    m.speed = VDVAR(DIFF_MAX_SPEED)[Robot::GotoPointMove];
+    m.radius = DIFFBOT_RADIUS;
+  } else {
+    m.accel = VDVAR(OMNI_MAX_ACCEL)[Robot::GotoPointMove];
+    m.speed = VDVAR(OMNI_MAX_SPEED)[Robot::GotoPointMove];
+    m.radius = OMNIBOT_RADIUS;
+  }
+
+  if (id >= n_ours) n_ours = id + 1;
+}
+
+void play_rollout::set_opponent(int id,vector2d p,vector2d v)
+{
+  opp_pos[id] = p;
+  opp_vel[id] = v;
+
+  if (id >= n_opp) n_opp = id + 1;
+}
+
+void play_rollout::command(int id,const Robot::RobotCommand &c)
+{
+  mover &m = ours[id];
+
+  m.chase = m.kicks = m.carries = false;
+  m.target = m.pos;
+
+  switch(c.cmd) {
+  case Robot::CmdPosition:
+    m.target = c.target;
+    break;
+  case Robot::CmdMoveBall:
+    m.chase = m.kicks = true;
+    m.kick_to = c.ball_target;
+    break;
+  case Robot::CmdDribble:
+    m.chase = m.carries = true;
+    m.target = c.target;
+    break;
+  case Robot::CmdSteal:
+  case Robot::CmdSpin:
+    m.chase = true;
+    break;
+  default:
+    break;
+  }
+}
+
+// Heads for the target as fast as it can while still able to stop
+// there.
+void play_rollout::move(mover &m,double dt)
+{
+  vector2d d = m.target - m.pos;
+  double dist = d.length();
+  double s = sqrt(2 * m.accel * dist);
+
+  if (s > m.speed) s = m.speed;
+
+  vector2d dv = ((dist > 0.0)? d * (s / dist) : vector2d(0,0)) - m.vel;
+  double max_dv = m.accel * dt;
+
+  if (dv.sqlength() > max_dv * max_dv) dv = dv.norm(max_dv);
+
+  m.vel += dv;
+  m.pos += m.vel * dt;
+}
+
+// Who, if anyone, gets the free ball this step.
+void play_rollout::touch_ball()
+{
+  int best = ROLLOUT_NOBODY;
+  double best_d = 0.0;
+
+  for(int i=0; i<n_ours; i++) {
+    double reach = ours[i].radius + BALL_RADIUS;
+    double d = sqdistance(ours[i].pos,ball_pos);
+
+    if (i == kicker) {
+      if (d > sq(reach * 2)) kicker = ROLLOUT_NOBODY;
+      continue;
+    }
+
+    if (d < sq(reach) && (best == ROLLOUT_NOBODY || d < best_d)) {
+      best = i;
+      best_d = d;
+    }
+  }
+
+  for(int i=0; i<n_opp; i++) {
+    double d = sqdistance(opp_pos[i],ball_pos);
+
+    if (d < sq(ROBOT_DEF_WIDTH_H + BALL_RADIUS) &&
+	(best == ROLLOUT_NOBODY || d < best_d)) {
+      best = ROLLOUT_THEM;
+      best_d = d;
+    }
+  }
+
+  if (best == ROLLOUT_NOBODY || best == ROLLOUT_THEM) {
+    owner = best;
+    return;
+  }
+
+  mover &m = ours[best];
+
+  if (m.kicks) {
+    ball_vel = (m.kick_to - ball_pos).norm(ROLLOUT_KICK_SPEED);
+    kicker = best;
+  } else {
+    owner = best;
+  }
+}
+
+bool play_rollout::run(double duration,double dt,double deadline)
+{
+  vector2d lim(FIELD_LENGTH_H,FIELD_WIDTH_H);
+  int steps = 0;
+
+  finished = false;
+
+  while(elapsed < duration) {
+    if (deadline > 0 && ++steps % ROLLOUT_CLOCK_STEPS == 0 &&
+	timer::now() > deadline)
+      return(false);
+
+    for(int i=0; i<n_ours; i++) {
+      mover &m = ours[i];
+
+      if (m.chase && owner != i) m.target = ball_pos;
+      move(m,dt);
+    }
+
+    for(int i=0; i<n_opp; i++) {
+      opp_pos[i] += opp_vel[i] * dt;
+      opp_pos[i].x = bound(opp_pos[i].x,-lim.x,lim.x);
+      opp_pos[i].y = bound(opp_pos[i].y,-lim.y,lim.y);
+    }
+
+    if (owner >= 0) {
+      // carried in front of the robot, towards where it's going
+      mover &m = ours[owner];
+      vector2d d = m.target - m.pos;
+
+      if (d.sqlength() < 1.0) d = ball_pos - m.pos;
+      ball_pos = m.pos + d.norm(m.radius + BALL_RADIUS);
+      ball_vel = m.vel;
+    } else {
+      double s = ball_vel.length();
+      double ds = decel * dt;
+
+      ball_vel = (s > ds)? ball_vel * ((s - ds) / s) : vector2d(0,0);
+      ball_pos += ball_vel * dt;
+
+      touch_ball();
+    }
+
+    elapsed += dt;
+
+    // goals, then the walls
+    if (fabs(ball_pos.x) > lim.x) {
+      if (fabs(ball_pos.y) < GOAL_WIDTH_H) {
+	goal = (ball_pos.x > 0)? 1 : -1;
+	break;
+      }
+      ball_pos.x = bound(ball_pos.x,-lim.x,lim.x);
+      ball_vel.x *= -ROLLOUT_WALL_BOUNCE;
+    }
+    if (fabs(ball_pos.y) > lim.y) {
+      ball_pos.y = bound(ball_pos.y,-lim.y,lim.y);
+      ball_vel.y *= -ROLLOUT_WALL_BOUNCE;
+    }
+
+    if (owner == ROLLOUT_THEM) break;
+  }
+
+  finished = true;
+  return(true);
+}
+
+double play_rollout::outcome()
+{
+  if (goal) return(goal);
+
+  double v = 0.5 * ball_pos.x / FIELD_LENGTH_H;
+
+  if (owner >= 0) v += 0.3;
+  else if (owner == ROLLOUT_THEM) v -= 0.3;
+
+  return(v);
+}
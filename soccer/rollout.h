@@ -0,0 +1,96 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// A quick, rough look at how a play might go: our robots drive
+// straight at their commands' targets within their motion limits, the
+// opponents carry on at their current velocities, and the ball rolls
+// with friction until someone reaches it.  A robot of ours reaching it
+// kicks it if its command moves the ball, and otherwise carries it.
+// Theirs keep it.  The state is a fixed size, so it copies cheaply,
+// and stepping never allocates.
+
+#ifndef __ROLLOUT_H__
+#define __ROLLOUT_H__
+
+#include "geometry.h"
+#include "constants.h"
+#include "robot.h"
+
+class World;
+class WorldSnapshot;
+
+// most plays PlayBook::select() rolls out
+#define ROLLOUT_MAX_PLAYS 8
+
+// who has the ball
+#define ROLLOUT_NOBODY -1
+#define ROLLOUT_THEM   -2
+
+class play_rollout{
+  struct mover{
+    vector2d pos,vel;
+    vector2d target;   // where it's going, unless it chases the ball
+    vector2d kick_to;  // where it kicks the ball, if it kicks
+    bool chase,kicks,carries;
+    double accel,speed,radius;
+  };
+
+  mover ours[MAX_TEAM_ROBOTS];
+  vector2d opp_pos[MAX_TEAM_ROBOTS],opp_vel[MAX_TEAM_ROBOTS];
+  int n_ours,n_opp;
+
+  vector2d ball_pos,ball_vel;
+  double decel;
+  int owner;   // teammate id or ROLLOUT_*
+  int kicker;  // not to touch the ball again until it's clear
+  int goal;    // 1 if we scored, -1 if they did
+  double elapsed;
+  bool finished;
+
+  void move(mover &m,double dt);
+  void touch_ball();
+public:
+  play_rollout() {n_ours=n_opp=0; owner=kicker=ROLLOUT_NOBODY; goal=0;
+                  decel=elapsed=0; finished=false;}
+
+  // Starts from the world now, with our robots holding their places
+  // until they're given commands.
+  void set(World &world);
+  void set(const WorldSnapshot &s);
+
+  void set_ball(vector2d p,vector2d v);
+  void set_teammate(int id,vector2d p,vector2d v,int type);
+  void set_opponent(int id,vector2d p,vector2d v);
+
+  // What our robot id does: CmdPosition goes to the target, the ball
+  // commands go for the ball (and CmdMoveBall kicks it at the
+  // ball_target), and the others wait.
+  void command(int id,const Robot::RobotCommand &c);
+
+  // Steps dt at a time until duration has gone by, a goal is scored
+  // or they get the ball, or until the wall clock passes deadline (if
+  // it's positive).  Returns whether it got to the end.
+  bool run(double duration,double dt,double deadline);
+
+  // From 1 for scoring to -1 for conceding, in between for who ends
+  // up with the ball and how far upfield it is.  Only meaningful once
+  // run() has returned true.
+  double outcome();
+  bool done() {return(finished);}
+  double time() {return(elapsed);}
+};
+
+#endif /*__ROLLOUT_H__*/
@@ -23,8 +23,6 @@
 #include <stdio.h>
 #include <getopt.h>
 
-#include <deque>
-
 #include <configreader.h>
 
 #include "socket.h"
@@ -41,6 +39,7 @@
 #include "simple_tactics.h"
 
 #include "strategy.h"
+#include "frame_arena.h"
 
 #include "soccer.h"
 
@@ -72,15 +71,21 @@ Strategy strategy;
 // Gui Tactics.  These override strategy's tactics.
 Tactic *gui_tactics[MAX_TEAM_ROBOTS] = { NULL };
 
-// Gui Messages
+// Gui Messages, queued in a fixed ring so that debugging output never
+// allocates.  Messages that find the queue full are dropped.
+#define GMSG_QUEUE_SIZE 1024
+
 struct gmsg {
   char m[net_gui_out_maxsize];
   int size;
 };
 
-deque<gmsg> gmsg_queue;
+gmsg gmsg_queue[GMSG_QUEUE_SIZE];
+int gmsg_head = 0, gmsg_count = 0;
 bool run;
 
+CR_DECLARE(PRINT_FRAME_ALLOCS);
+
 /******************************* PROTOTYPES *************************/
 
 // Static Function Declarations
@@ -122,6 +127,8 @@ int main(int argc, char *argv[])
   char *tactic_string = NULL;
 
   double t;
+  long allocs, frame_allocs = 0;
+  int alloc_frames = 0;
 
   // process the command line
   char c;
@@ -218,13 +225,20 @@ int main(int argc, char *argv[])
   signal(SIGINT,handle_stop);
   signal(SIGALRM,handle_alarm);
 
+  CR_SETUP(robot, PRINT_FRAME_ALLOCS, CR_INT);
+
   // main loop
   run = true;
 
   while(run) {
+    // Last frame's scratch memory is done with.
+    frame_mem.reset();
+
     // Read an incoming vision updates.
     do_vision_recv();
 
+    allocs = heap_alloc_count();
+
     // initialize tactics from command line
     if (tactic_string) {
       for(int i=0; i<world.n_teammates; i++)
@@ -232,6 +246,8 @@ int main(int argc, char *argv[])
       tactic_string = NULL; 
     }
 
+    world.collectPlans();
+
     if (robot_test) {
       for(int i=0; i<world.n_teammates; i++) {
 	t = 1.0*world.time + 0.60*i;
@@ -240,6 +256,7 @@ int main(int argc, char *argv[])
 	world.robot[i]->run(world, rcmd);
       } 
 
+      world.solvePlans();
       client.Send();
     } else {
 
@@ -259,7 +276,8 @@ int main(int argc, char *argv[])
 	} 
       }
       
-      // Send all the radio commands.
+      // Solve the robots' path plans and send all the radio commands.
+      world.solvePlans();
       client.Send();
       
       // Strategy may need some more intensive thinking time.  This
@@ -270,6 +288,19 @@ int main(int argc, char *argv[])
 
     }
 
+    // Heap use by strategy, tactics and planning, which should be none
+    // once every path through them has run.
+    frame_allocs += heap_alloc_count() - allocs;
+
+    if (IVAR(PRINT_FRAME_ALLOCS) > 0 &&
+	++alloc_frames % IVAR(PRINT_FRAME_ALLOCS) == 0) {
+      fprintf(stderr, "Frame: %.2f heap allocations per frame, "
+	      "%ld bytes scratch\n",
+	      (double) frame_allocs / IVAR(PRINT_FRAME_ALLOCS),
+	      (long) frame_mem.capacity());
+      frame_allocs = 0;
+    }
+
     // Handle gui connections.
     while(gui_s.ready_for_accept()) gui_s.accept();
     
@@ -286,12 +317,14 @@ int main(int argc, char *argv[])
 // Global Functions
 void gui_debug(const net_gdebug &g)
 {
-  gmsg a;
+  if (gmsg_count >= GMSG_QUEUE_SIZE) return;
+
+  gmsg &a = gmsg_queue[(gmsg_head + gmsg_count) % GMSG_QUEUE_SIZE];
 
   a.size = g.size();
   memcpy(a.m, &g, a.size); 
 
-  gmsg_queue.push_back(a);
+  gmsg_count++;
 }
 
 void gui_debug_line(const char robot, const char level, 
@@ -395,12 +428,13 @@ static void do_vision_recv()
 
 static void do_gui_send()
 {
-  while(gui_s.ready_for_send() && !gmsg_queue.empty()) {
-    gui_s.send(gmsg_queue.front().m, gmsg_queue.front().size);
-    gmsg_queue.pop_front();
+  while(gui_s.ready_for_send() && gmsg_count > 0) {
+    gui_s.send(gmsg_queue[gmsg_head].m, gmsg_queue[gmsg_head].size);
+    gmsg_head = (gmsg_head + 1) % GMSG_QUEUE_SIZE;
+    gmsg_count--;
   }
 
-  if (gui_s.get_status() != Socket::Server) gmsg_queue.clear();
+  if (gui_s.get_status() != Socket::Server) gmsg_count = 0;
 }
 
 static void do_gui_recv()
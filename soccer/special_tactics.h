@@ -54,23 +54,16 @@ public:
     return (world.game_state == 's') ? Succeeded : InProgress;
   }
 
-  virtual int selectRobot(World &world, bool candidates[], double bias[]) {
-    int best_i = -1;
-    double best = 0;
-
+  // The robot already on it keeps it, otherwise the one nearest the
+  // ball, with its distance in metres standing in for the time.
+  virtual void roleCosts(World &world, bool candidates[], double bias[],
+			 double times[], double costs[]) {
     for(uint i=0; i<MAX_TEAM_ROBOTS; i++) {
-      if (!candidates[i]) 
-	continue;
-      if (bias[i] < 0.0) 
-	return i;
-      double d = (world.teammate_position(i) - world.ball_position()).sqlength();
-      if ((best_i < 0) || (d < best)) { 
-	best = d; 
-	best_i = i; 
-      }
+      if (!candidates[i]) costs[i] = 0.0;
+      else if (bias[i] < 0.0) costs[i] = -TACTIC_UNFIT_COST;
+      else costs[i] = (world.teammate_position(i) - 
+		       world.ball_position()).length() / 1000.0;
     }
-
-    return best_i;
   }
 
   virtual void command(World &world, int me, Robot::RobotCommand &command,
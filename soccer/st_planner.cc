@@ -0,0 +1,400 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include "geometry.h"
+#include "constants.h"
+#include "timer.h"
+
+#include "obstacle.h"
+#include "path_planner.h"
+#include "st_planner.h"
+
+void st_planner::init(int _max_nodes,double _goal_target_prob,
+                      double _step_time,double _horizon)
+{
+  max_nodes = bound(_max_nodes,1,ST_MAX_NODES);
+  goal_target_prob = _goal_target_prob;
+  step_time = _step_time;
+  horizon = _horizon;
+  max_accel = max_speed = 1000;
+
+  rng[0] = 0x330E;
+  rng[1] = lrand48();
+  rng[2] = lrand48();
+
+  num_nodes = 0;
+  last_iterations = 0;
+  last_slack = last_dist = 0.0;
+}
+
+st_state *st_planner::add_node(st_state &s,st_state *parent)
+{
+  if(num_nodes >= max_nodes) return(NULL);
+
+  st_state &n = node[num_nodes];
+  n = s;
+  n.parent = parent;
+
+  px[num_nodes] = n.pos.x;
+  py[num_nodes] = n.pos.y;
+  vx[num_nodes] = n.vel.x;
+  vy[num_nodes] = n.vel.y;
+  num_nodes++;
+
+  return(&n);
+}
+
+vector2f st_planner::choose_target()
+{
+  vector2f p;
+
+  if(drand() < goal_target_prob) return(goal);
+
+  p.set((FIELD_LENGTH_H+GOAL_DEPTH)*sdrand(),FIELD_WIDTH_H*sdrand());
+  return(p);
+}
+
+// Nearest by where each node would coast to in a step, so nodes
+// already heading for the target are preferred.
+st_state *st_planner::find_nearest(vector2f target)
+{
+  float dx,dy,d,best_d;
+  int i,best;
+
+  best = 0;
+  best_d = -1;
+
+  for(i=0; i<num_nodes; i++){
+    dx = px[i] + vx[i]*step_time - target.x;
+    dy = py[i] + vy[i]*step_time - target.y;
+    d = dx*dx + dy*dy;
+    if(best_d<0 || d<best_d){
+      best_d = d;
+      best = i;
+    }
+  }
+
+  return(&node[best]);
+}
+
+// Checks the step s0->s1 against each enabled obstacle.  For circles
+// the closest approach is found in the frame moving with the obstacle.
+// A step that starts inside an obstacle is allowed if it's leaving.
+bool st_planner::check(st_state &s0,st_state &s1)
+{
+  state a,b;
+  vector2f c0,c1,d0,dd,m;
+  float t0,t1,r,l,u;
+  int i;
+
+  a.pos = s0.pos;
+  b.pos = s1.pos;
+
+  t0 = (s0.t < horizon)? s0.t : horizon;
+  t1 = (s1.t < horizon)? s1.t : horizon;
+
+  for(i=0; i<obs->num; i++){
+    if(!obs->is_enabled(i)) continue;
+    obstacle &o = obs->obs[i];
+
+    if(o.type == OBS_CIRCLE){
+      c0 = o.pos + o.vel*t0;
+      c1 = o.pos + o.vel*t1;
+      d0 = s0.pos - c0;
+      dd = (s1.pos - s0.pos) - (c1 - c0);
+      r = o.rad.x + ROBOT_RADIUS;
+
+      l = dd.sqlength();
+      u = (l > 0)? bound(-d0.dot(dd)/l,0.0f,1.0f) : 0.0f;
+      m = d0 + dd*u;
+
+      if(m.sqlength() < r*r){
+        if(d0.sqlength() >= r*r) return(false);
+        if((d0 + dd).sqlength() < d0.sqlength()) return(false);
+      }
+    }else{
+      if(!o.check(a,b) && o.check(a)) return(false);
+    }
+  }
+
+  if(!obs->check_static(a,b) && obs->check_static(a)) return(false);
+
+  return(true);
+}
+
+// Accelerates from s towards target for one step, aiming for the
+// fastest speed from which we could still stop there.
+st_state *st_planner::extend(st_state *s,vector2f target)
+{
+  st_state n;
+  vector2f d,dv;
+  float l,sp,dvmax;
+
+  d = target - s->pos;
+  l = d.length();
+  sp = sqrt(2*max_accel*l);
+  if(sp > max_speed) sp = max_speed;
+
+  if(l > EPSILON){
+    dv = d*(sp/l) - s->vel;
+  }else{
+    dv = -s->vel;
+  }
+
+  dvmax = max_accel*step_time;
+  l = dv.length();
+  if(l > dvmax) dv *= dvmax / l;
+
+  n.vel = s->vel + dv;
+  l = n.vel.length();
+  if(l > max_speed) n.vel *= max_speed / l;
+
+  n.pos = s->pos + (s->vel + n.vel)*(0.5*step_time);
+  n.t = s->t + step_time;
+
+  if(!check(*s,n)) return(NULL);
+  return(add_node(n,s));
+}
+
+st_state st_planner::plan(obstacles *_obs,int obs_mask,
+                          vector2f pos,vector2f vel,vector2f _goal,
+                          double lookahead,double deadline)
+{
+  st_state initial,*best,*n,*p;
+  vector2f target;
+  double d,nd;
+  int i;
+
+  obs = _obs;
+  obs->set_mask(obs_mask);
+  goal = _goal;
+
+  initial.pos = pos;
+  initial.vel = vel;
+  initial.t = 0;
+
+  num_nodes = 0;
+  best = add_node(initial,NULL);
+  d = Vector::distance(best->pos,goal);
+
+  // head straight for the goal first, as path_planner tries the direct
+  // line, then grow the tree from there if that runs into something
+  n = best;
+  for(i=0; i<max_nodes/4 && n && d>NEAR; i++){
+    n = extend(n,goal);
+    if(n){
+      best = n;
+      d = Vector::distance(n->pos,goal);
+    }
+  }
+
+  for(i=0; i<max_nodes && num_nodes<max_nodes && d>NEAR; i++){
+    target = choose_target();
+    n = extend(find_nearest(target),target);
+
+    if(n){
+      nd = Vector::distance(n->pos,goal);
+      if(nd < d){
+        best = n;
+        d = nd;
+      }
+    }
+
+    if(deadline>0 && i%PLAN_DEADLINE_CHECK==0 && timer::now()>deadline){
+      break;
+    }
+  }
+
+  last_iterations = i;
+  last_dist = d;
+  last_slack = (deadline > 0)? deadline - timer::now() : 0.0;
+
+  // already there
+  if(best==&node[0] && d<=NEAR){
+    initial.pos = goal;
+    initial.vel.set(0,0);
+    return(initial);
+  }
+
+  // back up the best path to lookahead seconds from now
+  p = best;
+  while(p->parent && p->t > lookahead) p = p->parent;
+
+  return(*p);
+}
+
+//====================================================================//
+//    Benchmark: "make st_planner_test"
+//====================================================================//
+
+#ifdef TEST_MAIN
+
+#include "configreader.h"
+
+// Drives a robot across a field crowded with robots moving at random,
+// replanning every frame with path_planner (robots as circles where
+// we'd meet them, as nav_to_point has always done, or swept over time
+// with the speed capped by the time to collision) or the space-time
+// planner, and counts how often it hits someone.
+
+#define BENCH_SCENES   200
+#define BENCH_ROBOTS   9
+#define BENCH_FRAMES   600
+#define BENCH_ACCEL    3500
+#define BENCH_SPEED    1300
+#define BENCH_OBS_RAD  90
+#define BENCH_MIN_SPEED 300
+
+#define BENCH_GUESS 0
+#define BENCH_SWEEP 1
+#define BENCH_KINO  2
+#define BENCH_MODES 3
+
+struct bench_result{
+  int reached,collisions,frames;
+  double plan_time;
+};
+
+static void run_scene(path_planner &pp,int mode,long seed,bench_result &r)
+{
+  vector2f op[BENCH_ROBOTS],ov[BENCH_ROBOTS];
+  vector2f pos,vel,goal,vd,dv,q;
+  obstacles obs;
+  state initial,g,target;
+  double t,s,rs,l,speed;
+  int i,f,obs_id;
+  bool touching;
+  timer tm;
+
+  srand48(seed);
+  for(i=0; i<BENCH_ROBOTS; i++){
+    op[i].set(FIELD_LENGTH_H*0.8*(2*drand48()-1),
+              FIELD_WIDTH_H*0.8*(2*drand48()-1));
+    ov[i].set(1000*(2*drand48()-1),1000*(2*drand48()-1));
+  }
+  pos.set(-FIELD_LENGTH_H+300,FIELD_WIDTH_H*0.8*(2*drand48()-1));
+  goal.set( FIELD_LENGTH_H-300,FIELD_WIDTH_H*0.8*(2*drand48()-1));
+  vel.set(0,0);
+  touching = false;
+
+  for(f=0; f<BENCH_FRAMES; f++){
+    obs.clear();
+    rs = vel.length();
+    for(i=0; i<BENCH_ROBOTS; i++){
+      if(mode != BENCH_GUESS){
+        t = 0;
+      }else{
+        // as nav_to_point does
+        t = closest_point_time(pos,vel,op[i],ov[i]);
+        s = ov[i].length();
+        t *= rs / (rs + s + EPSILON);
+        if(t > 4.0) t = 4.0;
+      }
+      q = op[i] + ov[i]*t;
+      obs.add_circle(q.x,q.y,BENCH_OBS_RAD,ov[i].x,ov[i].y,1);
+    }
+
+    if(mode == BENCH_SWEEP) obs.set_sweep(BENCH_SPEED,1.5);
+
+    initial.pos = pos;
+    g.pos = goal;
+    obs_id = -1;
+
+    tm.start();
+    if(mode == BENCH_KINO){
+      target = pp.plan_kino(&obs,1,initial,vel,g,BENCH_ACCEL,BENCH_SPEED,
+                            0.3);
+      vd = pp.result_vel + (target.pos - (pos + vel*0.3)) * (1/0.3);
+    }else{
+      target = pp.plan(&obs,1,initial,g,obs_id);
+      speed = BENCH_SPEED;
+      if(pp.last_ttc >= 0){
+        // as goto_point_omni does
+        s = BENCH_ACCEL*pp.last_ttc;
+        if(s < BENCH_MIN_SPEED) s = BENCH_MIN_SPEED;
+        if(s < speed) speed = s;
+      }
+      vd = target.pos - pos;
+      l = vd.length();
+      s = sqrt(2*BENCH_ACCEL*Vector::distance(pos,goal));
+      if(l > EPSILON) vd *= ((s < speed)? s : speed) / l;
+    }
+    tm.end();
+    r.plan_time += tm.time();
+    r.frames++;
+
+    // accelerate towards the commanded velocity
+    dv = vd - vel;
+    l = dv.length();
+    if(l > BENCH_ACCEL*FRAME_PERIOD) dv *= BENCH_ACCEL*FRAME_PERIOD / l;
+    vel += dv;
+    l = vel.length();
+    if(l > BENCH_SPEED) vel *= BENCH_SPEED / l;
+    pos += vel*FRAME_PERIOD;
+
+    // move the other robots, bouncing off the walls
+    for(i=0; i<BENCH_ROBOTS; i++){
+      op[i] += ov[i]*FRAME_PERIOD;
+      if(fabs(op[i].x) > FIELD_LENGTH_H) ov[i].x = -ov[i].x;
+      if(fabs(op[i].y) > FIELD_WIDTH_H) ov[i].y = -ov[i].y;
+    }
+
+    // count each time we come into contact
+    for(i=0; i<BENCH_ROBOTS; i++){
+      if(Vector::distance(pos,op[i]) < BENCH_OBS_RAD+ROBOT_RADIUS) break;
+    }
+    if(i<BENCH_ROBOTS && !touching) r.collisions++;
+    touching = (i < BENCH_ROBOTS);
+
+    if(Vector::distance(pos,goal) < NEAR){
+      r.reached++;
+      break;
+    }
+  }
+}
+
+int main(int argc,char **argv)
+{
+  static const char *name[BENCH_MODES] = {"path_planner","swept","st_planner"};
+  static path_planner pp;
+  bench_result r[BENCH_MODES];
+  int k,j;
+
+  mzero(r);
+  pp.init(400,100,0.15,0.75,100);
+
+  for(k=0; k<BENCH_MODES; k++){
+    for(j=0; j<BENCH_SCENES; j++) run_scene(pp,k,j+1,r[k]);
+  }
+
+  printf("%d scenes, %d robots moving at up to 1m/s\n",
+         BENCH_SCENES,BENCH_ROBOTS);
+  printf("%-12s %8s %10s %12s %10s\n",
+         "","reached","collisions","frames/scene","usec/plan");
+  for(k=0; k<BENCH_MODES; k++){
+    printf("%-12s %8d %10d %12.1f %10.1f\n",
+           name[k],
+           r[k].reached,r[k].collisions,
+           (double)r[k].frames/BENCH_SCENES,
+           r[k].plan_time/r[k].frames*1E6);
+  }
+
+  return(0);
+}
+
+#endif
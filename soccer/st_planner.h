@@ -0,0 +1,86 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// A space-time RRT for omni robots.  Nodes are (position, velocity,
+// time) states, and each extension accelerates towards the target for
+// a fixed time step within the robot's acceleration and speed limits.
+// Circle obstacles move with their velocities, so a step is checked
+// against where each robot will be during it rather than against a
+// circle inflated at a guessed collision time.  Other obstacles are
+// static.  Nodes live in a fixed arena, so planning never allocates.
+
+#ifndef __ST_PLANNER_H__
+#define __ST_PLANNER_H__
+
+#include <stdlib.h>
+
+#include "obstacle.h"
+
+#define ST_MAX_NODES 250
+
+struct st_state{
+  vector2f pos,vel;
+  float t;
+  st_state *parent;
+};
+
+class st_planner{
+  st_state node[ST_MAX_NODES];
+  int num_nodes,max_nodes;
+
+  // node positions and velocities, for the nearest neighbor scan
+  float px[ST_MAX_NODES],py[ST_MAX_NODES];
+  float vx[ST_MAX_NODES],vy[ST_MAX_NODES];
+
+  double goal_target_prob;
+  double step_time;  // seconds per extension
+  double horizon;    // obstacles stop moving after this time
+  double max_accel,max_speed;
+
+  obstacles *obs;
+  vector2f goal;
+
+  unsigned short rng[3];
+  double drand()  {return(erand48(rng));}
+  double sdrand() {return(2*erand48(rng)-1);}
+
+protected:
+  st_state *add_node(st_state &s,st_state *parent);
+  vector2f choose_target();
+  st_state *find_nearest(vector2f target);
+  bool check(st_state &s0,st_state &s1);
+  st_state *extend(st_state *s,vector2f target);
+
+public:
+  // results of the last plan()
+  int last_iterations;
+  double last_slack;
+  double last_dist;
+
+  void init(int _max_nodes,double _goal_target_prob,
+            double _step_time,double _horizon);
+  void set_limits(double accel,double speed)
+    {max_accel = accel; max_speed = speed;}
+
+  // Plans from pos moving at vel to goal.  Returns the state on the
+  // best path found lookahead seconds from now, or its end if that's
+  // sooner.  A nonzero deadline is as for path_planner::plan().
+  st_state plan(obstacles *_obs,int obs_mask,
+                vector2f pos,vector2f vel,vector2f _goal,
+                double lookahead,double deadline = 0.0);
+};
+
+#endif /*__ST_PLANNER_H__*/
@@ -25,6 +25,8 @@
 
 #include <configreader.h>
 
+#include "timer.h"
+
 #include "world.h"
 #include "tactic.h"
 #include "goalie.h"
@@ -32,17 +34,28 @@
 #include "strategy.h"
 #include "parse.h"
 #include "simple_tactics.h"
+#include "assignment.h"
 
 static bool cr_setup = false;
 CR_DECLARE(PLAYEXEC_OPPORTUNISM);
 CR_DECLARE(PLAYEXEC_ROLE_SWITCHING);
 CR_DECLARE(PLAYEXEC_FIXED_ROLES);
 CR_DECLARE(PLAYEXEC_DEBUG_ROLE_SWITCHING);
+CR_DECLARE(PLAYEXEC_OPTIMAL_ROLES);
+CR_DECLARE(PLAYEXEC_ROLE_WEIGHT);
+CR_DECLARE(PLAYEXEC_SWITCH_COST);
 CR_DECLARE(RESPONSIBLE_MIN_RUNTIME);
 CR_DECLARE(RESPONSIBLE_MAX_RUNTIME);
 CR_DECLARE(CREDIT_MIN_RUNTIME);
 CR_DECLARE(PLAYBOOK_ADAPT_WEIGHTS);
 CR_DECLARE(PLAYBOOK);
+CR_DECLARE(PLAYBOOK_ROLLOUT);
+CR_DECLARE(PLAYBOOK_ROLLOUT_PLAYS);
+CR_DECLARE(PLAYBOOK_ROLLOUT_TIME);
+CR_DECLARE(PLAYBOOK_ROLLOUT_DEADLINE);
+CR_DECLARE(PLAYBOOK_ROLLOUT_BIAS);
+CR_DECLARE(THINK_THREAD);
+CR_DECLARE(THINK_MAX_STALENESS);
 
 PlayExecutor::PlayExecutor() 
 { 
@@ -111,59 +124,121 @@ void PlayExecutor::fixedAssignment(World &world)
   assign[play->getFixedRoleID(3)] = 3;
 }
 
-void PlayExecutor::initialAssignment(World &world) 
+// Every role's time for every candidate, in one pass before any is
+// assigned.  The robot tactics keep the commands they make, so the
+// robots that get the roles needn't make them again to run.
+void PlayExecutor::estimateTimes(World &world, 
+				 bool candidates[MAX_TEAM_ROBOTS])
+{
+  for(int i=0; i<MAX_PLAY_ROLES; i++)
+    if (tactics[i]) tactics[i]->estimatedTimes(world, candidates, times[i]);
+}
+
+// Hands out the roles to the candidates so their total cost is least.
+// Each role's costs are weighted by PLAYEXEC_ROLE_WEIGHT for every
+// role after it, so the earlier roles get their pick first.  With
+// PLAYEXEC_OPTIMAL_ROLES off each role takes the cheapest robot left
+// in turn instead.  If keep is set, robots cost PLAYEXEC_SWITCH_COST
+// less in the role they already have.
+void PlayExecutor::assignRoles(World &world, bool keep)
 {
   bool candidates[MAX_TEAM_ROBOTS];
+  double bias[MAX_TEAM_ROBOTS];
+  double costs[MAX_TEAM_ROBOTS];
+  int n_candidates = 0;
 
   makeCandidates(world, candidates);
-  
-  for(int i=0; i<MAX_PLAY_ROLES; i++) {
-    if (!tactics[i]) continue;
-    
-    int s = tactics[i]->selectRobot(world, candidates);
-    if (s < 0) assign[i] = -1;
-    else {
-      candidates[s] = false;
+  estimateTimes(world, candidates);
+
+  for(int r=0; r<MAX_TEAM_ROBOTS; r++)
+    if (candidates[r]) n_candidates++;
+
+  if (!IVAR(PLAYEXEC_OPTIMAL_ROLES)) {
+    for(int i=0; i<MAX_PLAY_ROLES; i++) {
+      if (!tactics[i]) { assign[i] = -1; continue; }
+
+      for(int r=0; r<MAX_TEAM_ROBOTS; r++) bias[r] = 0.0;
+      if (keep && assign[i] >= 0) bias[assign[i]] = -DVAR(PLAYEXEC_SWITCH_COST);
+
+      int s = tactics[i]->selectRobot(world, candidates, bias, times[i]);
+
       assign[i] = s;
+      if (s >= 0) candidates[s] = false;
     }
+
+    return;
+  }
+
+  // The roles that get a robot, in order, and the candidates.
+  int roles[MAX_PLAY_ROLES], robots[MAX_TEAM_ROBOTS];
+  int n_roles = 0, n_robots = 0;
+
+  for(int r=0; r<MAX_TEAM_ROBOTS; r++)
+    if (candidates[r]) robots[n_robots++] = r;
+
+  for(int i=0; i<MAX_PLAY_ROLES; i++) {
+    if (tactics[i] && n_roles < n_robots) roles[n_roles++] = i;
+    else assign[i] = -1;
+  }
+
+  double matrix[MAX_PLAY_ROLES * MAX_TEAM_ROBOTS];
+  double weight = 1.0;
+
+  for(int k=n_roles-1; k>=0; k--) {
+    int i = roles[k];
+
+    for(int r=0; r<MAX_TEAM_ROBOTS; r++) bias[r] = 0.0;
+    if (keep && assign[i] >= 0) bias[assign[i]] = -DVAR(PLAYEXEC_SWITCH_COST);
+
+    tactics[i]->roleCosts(world, candidates, bias, times[i], costs);
+
+    for(int c=0; c<n_robots; c++)
+      matrix[k * n_robots + c] = weight * costs[robots[c]];
+
+    weight *= DVAR(PLAYEXEC_ROLE_WEIGHT);
   }
+
+  // Totals are often below 0 with the keep bias, so failure (which
+  // can't happen with MAX_TEAM_ROBOTS <= ASSIGN_MAX) is its own case.
+  int col_of[MAX_PLAY_ROLES];
+  assign_rows(n_roles, n_robots, matrix, col_of);
+
+  for(int k=0; k<n_roles; k++)
+    assign[roles[k]] = robots[col_of[k]];
+}
+
+void PlayExecutor::initialAssignment(World &world) 
+{
+  assignRoles(world, false);
 }
 
 void PlayExecutor::checkAssignment(World &world) 
 {
   bool switched = false;
-  bool candidates[MAX_TEAM_ROBOTS];
+  assignment previous;
+
+  for(int i=0; i<MAX_PLAY_ROLES; i++) previous[i] = assign[i];
+
+  assignRoles(world, true);
+
+  if (!IVAR(PLAYEXEC_DEBUG_ROLE_SWITCHING)) return;
 
-  makeCandidates(world, candidates);
-  
   for(int i=0; i<MAX_PLAY_ROLES; i++) {
-    if (!tactics[i]) { assign[i] = -1; continue; }
+    int s = assign[i];
 
-    double bias[MAX_TEAM_ROBOTS] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
-    bias[assign[i]] = -0.3;
+    if (s < 0 || (s == previous[i] && !switched)) continue;
 
-    int s = tactics[i]->selectRobot(world, candidates, bias);
+    if (!switched) gui_debug_printf(-1, GDBG_STRATEGY, "-----\n");
 
-    if (s < 0) assign[i] = -1;
-    else {
-      if (IVAR(PLAYEXEC_DEBUG_ROLE_SWITCHING) && s != assign[i] || switched) {
-	if (!switched) gui_debug_printf(-1, GDBG_STRATEGY, "-----\n");
-
-	gui_debug_printf(-1, GDBG_STRATEGY,
-			 "ROLE %d: Previous = %d (%f), New = %d (%f).\n", 
-			 i, assign[i], 
-			 (assign[i] > 0 ? tactics[i]->estimatedTime(world, assign[i]) : -1),
-			 s, s > 0 ? tactics[i]->estimatedTime(world, s) : -1);
-	switched = true; 
-      }
-      
-      candidates[s] = false;
-      assign[i] = s;
-    }
+    gui_debug_printf(-1, GDBG_STRATEGY,
+		     "ROLE %d: Previous = %d (%f), New = %d (%f).\n", 
+		     i, previous[i], 
+		     (previous[i] >= 0 ? times[i][previous[i]] : -1),
+		     s, times[i][s]);
+    switched = true; 
   }
 
-  if (switched && IVAR(PLAYEXEC_DEBUG_ROLE_SWITCHING)) 
-    gui_debug_printf(-1, GDBG_STRATEGY, "-----\n");
+  if (switched) gui_debug_printf(-1, GDBG_STRATEGY, "-----\n");
 }
 
 void PlayExecutor::checkForOpportunity(World &world)
@@ -180,14 +255,17 @@ void PlayExecutor::checkForOpportunity(World &world)
 
   bool candidates[MAX_TEAM_ROBOTS];
 
+  double opportunity_times[MAX_TEAM_ROBOTS];
+
   makeCandidates(world, candidates);
+  tactic_opportunity->estimatedTimes(world, candidates, opportunity_times);
 
   double best_t = 0;
   int best_i = -1;
 
   for(int i=0; i<MAX_TEAM_ROBOTS; i++) {
     if (!candidates[i]) continue;
-    double t = tactic_opportunity->estimatedTime(world, i);
+    double t = opportunity_times[i];
 
     if (i == id_opportunity) t -= 0.2;
 
@@ -429,18 +507,173 @@ bool PlayBook::save(const char *filename)
   return true;
 }
 
+// Picks the PLAYBOOK_ROLLOUT_PLAYS applicable plays of most weight,
+// heaviest first.  Returns how many.
+int PlayBook::chooseRollouts(bool applicable[], int chosen[])
+{
+  int n = 0, k;
+  int max_plays = IVAR(PLAYBOOK_ROLLOUT_PLAYS);
+
+  if (max_plays > ROLLOUT_MAX_PLAYS) max_plays = ROLLOUT_MAX_PLAYS;
+
+  for(uint i=0; i<plays.size(); i++) {
+    if (!applicable[i]) continue;
+
+    // keep the heaviest, heaviest first
+    for(k=n; k>0 && weight(chosen[k-1]) < weight(i); k--)
+      if (k < max_plays) chosen[k] = chosen[k-1];
+    if (k < max_plays) {
+      chosen[k] = i;
+      if (n < max_plays) n++;
+    }
+  }
+
+  return n;
+}
+
+// A play starts with the first tactic of each role, handed out as the
+// executor would, less the goalie.
+void PlayBook::rolloutCommands(World &w, int play, bool given[],
+			       Robot::RobotCommand commands[])
+{
+  Play *p = plays[play];
+  bool candidates[MAX_TEAM_ROBOTS];
+  int id_goalie = (w.n_teammates > 1) ? w.n_teammates - 1 : -1;
+
+  for(int i=0; i<MAX_TEAM_ROBOTS; i++) {
+    candidates[i] = (i < w.n_teammates && i != id_goalie);
+    given[i] = false;
+  }
+
+  for(int i=0; i<MAX_PLAY_ROLES; i++) {
+    Tactic *t = p->getRole(i)[0];
+    if (!t) continue;
+
+    t = t->clone();
+
+    int s = t->selectRobot(w, candidates);
+
+    if (s >= 0) {
+      candidates[s] = false;
+      given[s] = t->estimatedCommand(w, s, commands[s]);
+    }
+
+    delete t;
+  }
+}
+
+bool PlayBook::prepareRollouts(World &w, rollout_job &j)
+{
+  bool applicable[plays.size()];
+
+  for(uint i=0; i<plays.size(); i++)
+    applicable[i] = plays[i]->isApplicable(w);
+
+  j.n = chooseRollouts(applicable, j.play);
+
+  for(int k=0; k<j.n; k++)
+    rolloutCommands(w, j.play[k], j.given[k], j.command[k]);
+
+  return j.n > 0;
+}
+
+// The think thread's rollouts are used if they're of the same plays
+// and no more than THINK_MAX_STALENESS old.
+bool PlayBook::aheadFor(World &w, int chosen[], int n)
+{
+  if (!have_ahead || ahead.n != n) return false;
+  if (w.time - ahead.time > DVAR(THINK_MAX_STALENESS)) return false;
+
+  for(int k=0; k<n; k++)
+    if (ahead.play[k] != chosen[k]) return false;
+
+  return true;
+}
+
+// Rolls out the chosen plays for PLAYBOOK_ROLLOUT_TIME, on the
+// planning threads, and scores each with its outcome, unless the think
+// thread has just done so.  The others score 0, as do any rollouts
+// still going at the deadline.
+void PlayBook::rollout(World &w, bool applicable[], double scores[])
+{
+  int chosen[ROLLOUT_MAX_PLAYS];
+  int n, k;
+
+  for(uint i=0; i<plays.size(); i++)
+    scores[i] = 0.0;
+
+  n = chooseRollouts(applicable, chosen);
+  if (n == 0) return;
+
+  if (aheadFor(w, chosen, n)) {
+    for(k=0; k<n; k++) {
+      if (ahead.done[k]) scores[chosen[k]] = ahead.outcome[k];
+
+      gui_debug_printf(-1, GDBG_STRATEGY, "  ROLLOUT %s: %s %g (ahead)\n",
+		       plays[chosen[k]]->name, 
+		       ahead.done[k] ? "outcome" : "timed out",
+		       ahead.outcome[k]);
+    }
+    return;
+  }
+
+  for(k=0; k<n; k++) {
+    bool given[MAX_TEAM_ROBOTS];
+    Robot::RobotCommand c[MAX_TEAM_ROBOTS];
+
+    rollouts[k].set(w);
+    rolloutCommands(w, chosen[k], given, c);
+
+    for(int i=0; i<MAX_TEAM_ROBOTS; i++)
+      if (given[i]) rollouts[k].command(i, c[i]);
+  }
+
+  rollout_deadline = timer::now() + DVAR(PLAYBOOK_ROLLOUT_DEADLINE);
+  w.runParallel(rolloutJob, this, n);
+
+  for(k=0; k<n; k++) {
+    if (rollouts[k].done()) scores[chosen[k]] = rollouts[k].outcome();
+
+    gui_debug_printf(-1, GDBG_STRATEGY, "  ROLLOUT %s: %s %g\n",
+		     plays[chosen[k]]->name, 
+		     rollouts[k].done() ? "outcome" : "timed out at",
+		     rollouts[k].done() ? rollouts[k].outcome() : 
+		     rollouts[k].time());
+  }
+}
+
+void PlayBook::rolloutJob(void *arg, int i)
+{
+  PlayBook *book = (PlayBook *) arg;
+
+  book->rollouts[i].run(DVAR(PLAYBOOK_ROLLOUT_TIME), FRAME_PERIOD,
+			book->rollout_deadline);
+}
+
 Play *PlayBook::select(World &w)
 {
   bool applicable[plays.size()];
+  double play_weights[plays.size()];
   double sum = 0.0;
 
   for(uint i=0; i<plays.size(); i++) {
     applicable[i] = plays[i]->isApplicable(w);
-    if (applicable[i]) { 
-      sum += weight(i);
-    }
+    play_weights[i] = applicable[i] ? weight(i) : 0.0;
+  }
+
+  // Lean towards the plays that went better when tried out.
+  if (IVAR(PLAYBOOK_ROLLOUT)) {
+    double scores[plays.size()];
+
+    rollout(w, applicable, scores);
+
+    for(uint i=0; i<plays.size(); i++)
+      play_weights[i] *= exp(DVAR(PLAYBOOK_ROLLOUT_BIAS) * scores[i]);
   }
 
+  for(uint i=0; i<plays.size(); i++)
+    sum += play_weights[i];
+
   if (sum == 0) return NULL;
 
   gui_debug_printf(-1, GDBG_STRATEGY, "SELECT PLAY\n");
@@ -448,7 +681,7 @@ Play *PlayBook::select(World &w)
   for(uint i=0; i<plays.size(); i++) {
     if (applicable[i]) {
       gui_debug_printf(-1, GDBG_STRATEGY, 
-		       "  %5g; %s; ", weight(i), plays[i]->name);
+		       "  %5g; %s; ", play_weights[i], plays[i]->name);
       results[i].gui_print();
     }
   }
@@ -457,7 +690,7 @@ Play *PlayBook::select(World &w)
 
   for(uint i=0; i<plays.size(); i++) {
     if (!applicable[i]) continue;
-    r -= weight(i);
+    r -= play_weights[i];
     if (r < 0) {
       gui_debug_printf(-1, GDBG_STRATEGY, "  Selected: %s\n", plays[i]->name);
       return plays[i];
@@ -488,10 +721,20 @@ Strategy::Strategy()
     CR_SETUP(strategy, PLAYEXEC_ROLE_SWITCHING, CR_INT);
     CR_SETUP(strategy, PLAYEXEC_FIXED_ROLES, CR_INT);
     CR_SETUP(strategy, PLAYEXEC_DEBUG_ROLE_SWITCHING, CR_INT);
+    CR_SETUP(strategy, PLAYEXEC_OPTIMAL_ROLES, CR_INT);
+    CR_SETUP(strategy, PLAYEXEC_ROLE_WEIGHT, CR_DOUBLE);
+    CR_SETUP(strategy, PLAYEXEC_SWITCH_COST, CR_DOUBLE);
     CR_SETUP(strategy, RESPONSIBLE_MIN_RUNTIME, CR_DOUBLE);
     CR_SETUP(strategy, RESPONSIBLE_MAX_RUNTIME, CR_DOUBLE);
     CR_SETUP(strategy, PLAYBOOK_ADAPT_WEIGHTS, CR_INT);
+    CR_SETUP(strategy, PLAYBOOK_ROLLOUT, CR_INT);
+    CR_SETUP(strategy, PLAYBOOK_ROLLOUT_PLAYS, CR_INT);
+    CR_SETUP(strategy, PLAYBOOK_ROLLOUT_TIME, CR_DOUBLE);
+    CR_SETUP(strategy, PLAYBOOK_ROLLOUT_DEADLINE, CR_DOUBLE);
+    CR_SETUP(strategy, PLAYBOOK_ROLLOUT_BIAS, CR_DOUBLE);
     CR_SETUP(strategy, CREDIT_MIN_RUNTIME, CR_DOUBLE);
+    CR_SETUP(strategy, THINK_THREAD, CR_INT);
+    CR_SETUP(strategy, THINK_MAX_STALENESS, CR_DOUBLE);
     doing = NONE;
     cr_setup = true;
   }
@@ -704,9 +947,28 @@ void Strategy::think(World &world)
   if (executor.isDone(world) != InProgress && world.game_state != 'S')
     playEnded(world, executor.isDone(world));
 
+  // Roll plays out ahead of the next selection.
+  if (IVAR(THINK_THREAD) && IVAR(PLAYBOOK_ROLLOUT)) thinkAhead(world);
+
   last_game_state = world.game_state;
 }
 
+// Takes what the think thread rolled out last, and gives it this
+// frame's plays to roll out if it's free.
+void Strategy::thinkAhead(World &world)
+{
+  rollout_job done;
+
+  if (!thinker.started() && !thinker.start(world)) return;
+
+  if (thinker.receive(done)) playbook.rolledAhead(done);
+
+  rollout_job *j = thinker.next();
+
+  if (j && world.game_state != 'S' && playbook.prepareRollouts(world, *j))
+    thinker.post(DVAR(PLAYBOOK_ROLLOUT_TIME), DVAR(THINK_MAX_STALENESS));
+}
+
 const double Warmup::goalpts[MAX_TEAM_ROBOTS][2] = 
   {{1000, 700}, {-1000, 700}, 
    {-1000, -700}, {1000, -700},
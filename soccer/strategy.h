@@ -31,6 +31,8 @@
 #include "ball_tactics.h"
 #include "goalie.h"
 #include "play.h"
+#include "rollout.h"
+#include "think_thread.h"
 
 class PlayExecutor {
 private:
@@ -55,6 +57,9 @@ private:
 
   Tactic *tactics[MAX_PLAY_ROLES];
   Tactic *tactic_opportunity;
+
+  // Each role's estimatedTime() for each candidate robot this frame.
+  double times[MAX_PLAY_ROLES][MAX_TEAM_ROBOTS];
   Tactic *busy_tactics[MAX_TEAM_ROBOTS];
 
   TGoalie *tactic_goalie;
@@ -63,6 +68,9 @@ private:
 
   void makeCandidates(World &world, bool candidates[MAX_TEAM_ROBOTS]);
 
+  void estimateTimes(World &world, bool candidates[MAX_TEAM_ROBOTS]);
+
+  void assignRoles(World &world, bool keep);
   void initialAssignment(World &world);
   void fixedAssignment(World &world);
 
@@ -124,8 +132,24 @@ private:
 
   double weight(uint index);
 
+  // Rollouts of the plays being chosen between.
+  play_rollout rollouts[ROLLOUT_MAX_PLAYS];
+  double rollout_deadline;
+
+  // The think thread's last rollouts, if any.
+  rollout_job ahead;
+  bool have_ahead;
+
+  int chooseRollouts(bool applicable[], int chosen[]);
+  void rolloutCommands(World &w, int play, bool given[],
+		       Robot::RobotCommand commands[]);
+  bool aheadFor(World &w, int chosen[], int n);
+
+  void rollout(World &w, bool applicable[], double scores[]);
+  static void rolloutJob(void *arg, int i);
+
 public:
-  PlayBook() { } 
+  PlayBook() { have_ahead = false; } 
 
   void add(Play *p, char *name, double w) { 
     plays.push_back(p); play_names.push_back(name); weights.push_back(w); 
@@ -137,6 +161,11 @@ public:
 
   Play *select(World &w);
 
+  // Fills in the plays select() would roll out now, for the think
+  // thread, and takes its outcomes back.  False if there are none.
+  bool prepareRollouts(World &w, rollout_job &j);
+  void rolledAhead(const rollout_job &j) { ahead = j; have_ahead = true; }
+
   void credit(Play *p, Status s) {
     for(uint i=0; i<plays.size(); i++)
       if (plays[i] == p) { results[i].incr(s); break; }
@@ -195,6 +224,10 @@ private:
 
   enum {NONE=0, PLAYS, WARMUP} doing;
 
+  think_thread thinker;
+
+  void thinkAhead(World &world);
+
 public:
   Strategy();
   
@@ -28,6 +28,18 @@
 #include "tactic.h"
 #include "configreader.h"
 
+static bool cr_setup = false;
+CR_DECLARE(TACTIC_REUSE_COMMAND);
+
+static void cr_setup_do()
+{
+  if (!cr_setup) {
+    CR_SETUP(tactic, TACTIC_REUSE_COMMAND, CR_INT);
+
+    cr_setup = true;
+  }
+}
+
 vector2d TCoordinate::asVectorNotAbsolute(World &w)
 {
   vector2d v = c;
@@ -221,21 +233,79 @@ Tactic *Tactic::parse(const char *string)
   return NULL;
 }
 
-int Tactic::selectRobot(World &world, bool candidates[], double bias[])
+void Tactic::roleCosts(World &world, bool candidates[], double bias[],
+		       double times[], double costs[])
 {
+  for(int i=0; i<MAX_TEAM_ROBOTS; i++)
+    costs[i] = candidates[i] ? times[i] + bias[i] : 0.0;
+}
+
+int Tactic::selectRobot(World &world, bool candidates[], double bias[],
+			double times[])
+{
+  double costs[MAX_TEAM_ROBOTS];
   int best = -1;
-  double best_t = 0.0;
+
+  roleCosts(world, candidates, bias, times, costs);
   
   for(int i=0; i<MAX_TEAM_ROBOTS; i++) {
     if (!candidates[i]) continue;
-    
-    double t = estimatedTime(world, i) + bias[i];
-    if (best < 0 || t < best_t) { best = i; best_t = t; }
+    if (best < 0 || costs[i] < costs[best]) best = i;
   }
   
   return best;
 }
 
+void RobotTactic::run(World &world, int me)
+{
+  Robot::RobotCommand the_command;
+  bool ignore_status;
+
+  cr_setup_do();
+
+  Estimate *e = IVAR(TACTIC_REUSE_COMMAND) ? cachedEstimate(world, me) : NULL;
+
+  if (e) {
+    the_command = e->command;
+    ignore_status = e->ignore_status;
+    // it's had its one use
+    e->stamp = -1;
+    drawCommand(world, me, the_command);
+  } else makeCommand(world, me, true, the_command, ignore_status);
+
+  the_status = world.robot[me]->run(world, the_command); 
+  if (ignore_status) the_status = InProgress;
+}
+
+void RobotTactic::drawCommand(World &world, int me, Robot::RobotCommand &c)
+{
+  vector2d mypos = world.teammate_position(me);
+
+  gui_debug_printf(me, GDBG_TACTICS, "%s: estimated command", name());
+  gui_debug_line(me, GDBG_TACTICS, mypos, c.target, G_ARROW_FORW);
+
+  switch (c.cmd) {
+  case Robot::CmdPosition:
+    gui_debug_line(me, GDBG_TACTICS, c.target, c.target + c.velocity,
+		   G_ARROW_FORW);
+    gui_debug_line(me, GDBG_TACTICS, c.target,
+		   c.target + vector2d(world.teammate_radius(me), 0)
+		   .rotate(c.angle));
+    break;
+  case Robot::CmdMoveBall:
+    gui_debug_line(me, GDBG_TACTICS, world.ball_position(), c.ball_target,
+		   G_ARROW_FORW);
+    break;
+  case Robot::CmdDribble:
+    gui_debug_line(me, GDBG_TACTICS, c.target,
+		   c.target + vector2d(world.teammate_radius(me), 0)
+		   .rotate(c.angle));
+    break;
+  default:
+    break;
+  }
+}
+
 void RobotTactic::makeCommand(World &world, int me, bool debug,
 			      Robot::RobotCommand &c, 
 			      bool &ignore_status)
@@ -104,6 +104,10 @@ public:
 
 typedef vector<int> TRoleMap;
 
+// Added by roleCosts() for a robot that's unfit for the tactic, so it
+// only gets it if nobody else can.
+#define TACTIC_UNFIT_COST 100.0 // s
+
 class Tactic {
 public:
   virtual const char *name() const { return "Unknown Tactic"; }
@@ -169,6 +173,18 @@ public:
 
   void setPriority(int _priority) {
     priority = _priority; }
+
+  // Sums up the priority and role maps, which change whenever the
+  // roles are reassigned.
+  unsigned int contextKey() {
+    unsigned int key = priority;
+    if (teammate_map)
+      for(uint i=0; i<teammate_map->size(); i++)
+	key = key * 31 + (*teammate_map)[i] + 1;
+    if (opponent_map)
+      for(uint i=0; i<opponent_map->size(); i++)
+	key = key * 31 + (*opponent_map)[i] + 1;
+    return key; }
   
   //
   // Tactic specified methods and fields.
@@ -177,18 +193,40 @@ public:
   bool active;  // Is true if this is an active tactic.
   bool manipulates_ball; // Is true if tactic manipulates the ball.
 
-  // Returns the robot most apt to accomplish the tactic.
-  // By default this is the robot with the lowest estimated time modulo
-  //  the provided time bias.
-  virtual int selectRobot(World &world, bool candidates[], double bias[]);
+  // Fills in what it costs for each candidate to take on the tactic,
+  // for handing out roles.  By default this is the robot's estimated
+  // time plus the provided time bias.  times[] holds each candidate's
+  // estimatedTime().
+  virtual void roleCosts(World &world, bool candidates[], double bias[],
+			 double times[], double costs[]);
+
+  // Returns the robot most apt to accomplish the tactic: the one with
+  // the lowest cost.
+  int selectRobot(World &world, bool candidates[], double bias[],
+		  double times[]);
+
+  int selectRobot(World &world, bool candidates[], double bias[]) {
+    double times[MAX_TEAM_ROBOTS];
+    estimatedTimes(world, candidates, times);
+    return selectRobot(world, candidates, bias, times); }
 
   int selectRobot(World &world, bool candidates[]) {
     static double bias[MAX_TEAM_ROBOTS] = {0};
     return selectRobot(world, candidates, bias); }
 
+  // Fills in estimatedTime() for each candidate.
+  void estimatedTimes(World &world, bool candidates[], double times[]) {
+    for(int i=0; i<MAX_TEAM_ROBOTS; i++)
+      times[i] = candidates[i] ? estimatedTime(world, i) : 0.0; }
+
   // Returns the time to accomplish the tactic.
   virtual double estimatedTime(World &world, int me) { return 0.0; }
 
+  // Gives the command the robot would run with, if the tactic runs
+  // robots by commands.
+  virtual bool estimatedCommand(World &world, int me,
+				Robot::RobotCommand &command) { return false; }
+
   // Returns the status of the tactic.  
   virtual Status isDone(World &world, int me) { return Succeeded; }
 
@@ -213,10 +251,33 @@ protected:
 		   Robot::RobotCommand &command,
 		   bool &ignore_status);
 
+  // Draws a command made without debugging output.
+  void drawCommand(World &world, int me, Robot::RobotCommand &command);
+
+private:
+  // The command estimatedTime() made for each robot, so run() and
+  // further estimates in the same frame needn't make it again.  It's
+  // good for the world.time and context it was made for.
+  struct Estimate {
+    double stamp;
+    unsigned int context;
+    Robot::RobotCommand command;
+    bool ignore_status;
+    double time;
+  };
+
+  Estimate estimates[MAX_TEAM_ROBOTS];
+
+  Estimate *cachedEstimate(World &world, int me) {
+    Estimate &e = estimates[me];
+    if (e.stamp == world.time && e.context == contextKey()) return &e;
+    return NULL; }
+
 public:
   RobotTactic(bool _active = false, bool _manipulates_ball = false) : 
     Tactic(_active, _manipulates_ball) { 
-    the_status = InProgress; }
+    the_status = InProgress; 
+    for(int i=0; i<MAX_TEAM_ROBOTS; i++) estimates[i].stamp = -1; }
 
   virtual void command(World &world, int me, Robot::RobotCommand &command,
 		       bool debug) { 
@@ -227,32 +288,40 @@ public:
     command.obs = 0;
   }
 
-  // This is slightly inefficient.  Both estimated_time() and doit()
-  // generate the command afresh.  But since the command may be robot
-  // dependent it's not something one can easily cache.
+  // The command is made once a frame for each robot by estimatedTime()
+  // and taken up by run(), as long as the roles the tactic sees
+  // haven't changed in between.
   //
-  // Also debugging output is not printed on call from estimatedTime()
-  // but are on the call from run().
+  // Debugging output is not printed on the call from estimatedTime(),
+  // so when run() reuses the command it draws the command itself: the
+  // target, velocity and facing, or where the ball is going.
 
 public:
   virtual double estimatedTime(World &world, int me) {
-    Robot::RobotCommand the_command;
+    Estimate *e = cachedEstimate(world, me);
+    if (e) return e->time;
+
+    e = &estimates[me];
+    makeCommand(world, me, false, e->command, e->ignore_status);
+    e->time = world.robot[me]->time(world, e->command);
+    e->stamp = world.time;
+    e->context = contextKey();
+
+    return e->time; }
+
+  virtual bool estimatedCommand(World &world, int me,
+				Robot::RobotCommand &command) {
+    Estimate *e = cachedEstimate(world, me);
     bool ignore_status;
 
-    makeCommand(world, me, false, the_command, ignore_status);
-    return world.robot[me]->time(world, the_command); }
+    if (e) command = e->command;
+    else makeCommand(world, me, false, command, ignore_status);
+    return true; }
 
   virtual Status isDone(World &world, int me) {
     return the_status; }
 
-  virtual void run(World &world, int me) {
-    Robot::RobotCommand the_command;
-    bool ignore_status;
-
-    makeCommand(world, me, true, the_command, ignore_status);
-    the_status = world.robot[me]->run(world, the_command); 
-    if (ignore_status) the_status = InProgress;
-  }
+  virtual void run(World &world, int me);
 };
 
 #endif
@@ -0,0 +1,116 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include "timer.h"
+
+#include "world.h"
+#include "world_snapshot.h"
+#include "think_thread.h"
+
+think_thread::think_thread()
+{
+  world = NULL;
+  running = false;
+  state = Empty;
+  snapshot = NULL;
+  job.n = 0;
+}
+
+bool think_thread::start(World &w)
+{
+  if (running) return(true);
+
+  world = &w;
+  world->wantSnapshots();
+  sem_init(&wake,0,0);
+
+  // sets up the rollout's config here rather than on the thread
+  rollout.set(w);
+
+  if (pthread_create(&thread,NULL,thread_main,this) != 0) {
+    fprintf(stderr,"WARNING: think_thread couldn't start a thread.\n");
+    return(false);
+  }
+  pthread_detach(thread);
+
+  running = true;
+  return(true);
+}
+
+bool think_thread::post(double _duration,double max_time)
+{
+  if (!running || state != Empty) return(false);
+
+  snapshot = world->acquireSnapshot();
+  if (!snapshot) return(false);
+
+  job.time = snapshot->time;
+  duration = _duration;
+  deadline = timer::now() + max_time;
+
+  // the job is written before the thread can see it posted
+  __sync_bool_compare_and_swap(&state,(int) Empty,(int) Posted);
+  sem_post(&wake);
+
+  return(true);
+}
+
+bool think_thread::receive(rollout_job &r)
+{
+  if (state != Done) return(false);
+
+  __sync_synchronize();
+  r = job;
+  __sync_bool_compare_and_swap(&state,(int) Done,(int) Empty);
+
+  return(true);
+}
+
+void think_thread::work()
+{
+  for(int k=0; k<job.n; k++) {
+    rollout.set(*snapshot);
+
+    for(int i=0; i<MAX_TEAM_ROBOTS; i++)
+      if (job.given[k][i]) rollout.command(i,job.command[k][i]);
+
+    job.done[k] = rollout.run(duration,FRAME_PERIOD,deadline);
+    job.outcome[k] = job.done[k] ? rollout.outcome() : 0.0;
+  }
+}
+
+void *think_thread::thread_main(void *arg)
+{
+  think_thread *t = (think_thread *) arg;
+
+  while(true) {
+    sem_wait(&t->wake);
+    if (t->state != Posted) continue;
+
+    __sync_synchronize();
+    t->work();
+
+    t->world->releaseSnapshot(t->snapshot);
+    t->snapshot = NULL;
+
+    // the outcomes are written before the caller can see it done
+    __sync_bool_compare_and_swap(&t->state,(int) Posted,(int) Done);
+  }
+
+  return(NULL);
+}
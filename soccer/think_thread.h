@@ -0,0 +1,95 @@
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+// Play rollouts (see rollout.h) done ahead of time on a thread of
+// their own, so choosing a play never waits on them.  Each frame,
+// after the radio commands are out, Strategy::think() fills in which
+// plays to roll out and what their roles are told to do, and posts
+// them with the frame's WorldSnapshot.  The thread rolls them out
+// from the snapshot and leaves the outcomes in the same mailbox.
+// There's one job in it at a time, and each side only moves it on
+// from the states it owns, so neither takes a lock.  A job the thread
+// is still on is left alone until it's done.
+
+#ifndef __THINK_THREAD_H__
+#define __THINK_THREAD_H__
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "constants.h"
+#include "robot.h"
+#include "rollout.h"
+
+class World;
+class WorldSnapshot;
+
+struct rollout_job{
+  double time; // of the snapshot the rollouts start from
+  int n;       // plays rolled out
+
+  // PlayBook index of each play, and the command its roles give each
+  // robot, if any
+  int play[ROLLOUT_MAX_PLAYS];
+  bool given[ROLLOUT_MAX_PLAYS][MAX_TEAM_ROBOTS];
+  Robot::RobotCommand command[ROLLOUT_MAX_PLAYS][MAX_TEAM_ROBOTS];
+
+  // filled in by the thread: whether each got to the end, and how
+  // it went if so
+  bool done[ROLLOUT_MAX_PLAYS];
+  double outcome[ROLLOUT_MAX_PLAYS];
+};
+
+class think_thread{
+  World *world;
+  pthread_t thread;
+  sem_t wake;
+  bool running;
+
+  // Empty: the caller may fill job in.  Posted: the thread has it.
+  // Done: the outcomes are in for the caller.
+  enum {Empty, Posted, Done};
+  volatile int state;
+
+  rollout_job job;
+  const WorldSnapshot *snapshot;
+  double duration,deadline;
+
+  play_rollout rollout;
+
+  void work();
+  static void *thread_main(void *arg);
+public:
+  think_thread();
+
+  // Starts the thread on w's snapshots.
+  bool start(World &w);
+  bool started() {return(running);}
+
+  // The job to fill in, or NULL while the thread has one.
+  rollout_job *next() {return((running && state == Empty)? &job : NULL);}
+
+  // Hands the filled in job to the thread, with the latest snapshot,
+  // to roll out for duration.  The thread gives up on rollouts still
+  // going max_time from now.  Returns false if there's no snapshot.
+  bool post(double duration,double max_time);
+
+  // Copies out the outcomes of the last job, if it's done, and empties
+  // the mailbox.
+  bool receive(rollout_job &r);
+};
+
+#endif /*__THINK_THREAD_H__*/
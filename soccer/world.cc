@@ -31,12 +31,17 @@
 #include "constants.h"
 #include "soccer.h"
 #include "world.h"
+#include "world_snapshot.h"
 
 #include "robot.h"
 
 CR_DECLARE(DZONE_HYSTERESIS_DURATION);
 CR_DECLARE(POSSESSION_US_HYSTERESIS_DURATION);
 CR_DECLARE(POSSESSION_THEM_HYSTERESIS_DURATION);
+CR_DECLARE(PLAN_FRAME_BUDGET);
+CR_DECLARE(PLAN_PRINT_BUDGET);
+CR_DECLARE(PLAN_THREADS);
+CR_DECLARE(WORLD_PUBLISH_SNAPSHOTS);
 
 static void cr_setup_do()
 {
@@ -46,6 +51,10 @@ static void cr_setup_do()
     CR_SETUP(strategy, DZONE_HYSTERESIS_DURATION, CR_DOUBLE);
     CR_SETUP(strategy, POSSESSION_US_HYSTERESIS_DURATION, CR_DOUBLE);
     CR_SETUP(strategy, POSSESSION_THEM_HYSTERESIS_DURATION, CR_DOUBLE);
+    CR_SETUP(robot, PLAN_FRAME_BUDGET, CR_DOUBLE);
+    CR_SETUP(robot, PLAN_PRINT_BUDGET, CR_INT);
+    CR_SETUP(robot, PLAN_THREADS, CR_INT);
+    CR_SETUP(robot, WORLD_PUBLISH_SNAPSHOTS, CR_INT);
 
     cr_setup = true;
   } 
@@ -54,6 +63,12 @@ static void cr_setup_do()
 World::World()
 {
   cr_setup_do();
+
+  snapshots = NULL;
+  published = NULL;
+  snapshots_wanted = false;
+
+  plans_deferred = false;
 }
 
 void World::init(int _side, int _color)
@@ -75,7 +90,10 @@ void World::init(int _side, int _color)
 
   now = LATENCY_DELAY;
 
-  game_state = 'S';
+  game_state = prev_game_state = 'S';
+
+  static_field.init();
+  quality.init();
 
   // Robot Internal State
   for(i=0; i<MAX_TEAM_ROBOTS; i++){
@@ -86,9 +104,15 @@ void World::init(int _side, int _color)
     robot[i]->init(i);
   }
 
+  if (IVAR(PLAN_THREADS) > 0) plan_threads.start(IVAR(PLAN_THREADS));
+
   // init the modeller data sructures
   modeller.initialize();
 
+  // snapshots
+  snapshots = new WorldSnapshot[WORLD_SNAPSHOTS];
+  published = NULL;
+
   // init roles
   orole_goalie = -1;
   trole_goalie = -1;
@@ -100,6 +124,15 @@ void World::update(const net_vframe &f)
   frame = f;
   time = f.timestamp;
 
+  // Planning Budget
+  static int plan_frames = 0;
+
+  if (IVAR(PLAN_PRINT_BUDGET) > 0 &&
+      ++plan_frames % IVAR(PLAN_PRINT_BUDGET) == 0)
+    planning.print(stderr);
+
+  planning.start_frame(DVAR(PLAN_FRAME_BUDGET));
+
   // Config
   tracker.SetConfig(f.config);
 
@@ -120,12 +153,14 @@ void World::update(const net_vframe &f)
       if (i == color) teammate_id_to_index[n_teammates++] = j;
       else opponent_id_to_index[n_opponents++] = j;
 
+      tracker.robots[i][j].observe_latency(f.robots[i][j].vision);
       tracker.robots[i][j].reset(time, (float *) &f.robots[i][j].state);
     }
   }
 
   // Game State
   goal_scored = 0;
+  prev_game_state = game_state;
 
   if (strchr("tTgGz", f.refstate) == NULL)
     game_state = f.refstate;
@@ -146,8 +181,113 @@ void World::update(const net_vframe &f)
   // Update High Level Information
   updateHighLevel();
 
+  // Shot and pass quality, with the planning threads, which are idle
+  // until the tactics have run.
+  quality.update(*this, plan_threads);
+
   // update the modeller
-  modeller.update(f);
+  modeller.update(*this);
+
+  publishSnapshot();
+}
+
+void World::publishSnapshot()
+{
+  WorldSnapshot *s = NULL, *old = published;
+
+  // Tabulating the predictions isn't free, so only with a reader.
+  if (!snapshots_wanted && !IVAR(WORLD_PUBLISH_SNAPSHOTS)) return;
+
+  // Write into a snapshot no one is reading.  With one writer and
+  // fewer than WORLD_SNAPSHOTS - 1 readers there's always one free.
+  for(int i=0; i<WORLD_SNAPSHOTS; i++) {
+    if (&snapshots[i] == old || snapshots[i].readers > 0) continue;
+    s = &snapshots[i]; break;
+  }
+
+  if (!s) {
+    fprintf(stderr, "WARNING: World::publishSnapshot() no free snapshot.\n");
+    return;
+  }
+
+  s->set(*this);
+
+  // Full barrier, so the snapshot is written before it's visible.
+  __sync_bool_compare_and_swap(&published, old, s);
+}
+
+void World::collectPlans()
+{
+  plans_deferred = (IVAR(PLAN_THREADS) > 0);
+}
+
+void World::solvePlans()
+{
+  path_planner *p[MAX_TEAM_ROBOTS];
+  int ids[MAX_TEAM_ROBOTS];
+  int n = 0;
+
+  plans_deferred = false;
+
+  for(int i=0; i<MAX_TEAM_ROBOTS; i++) {
+    if (!path[i].req_pending) continue;
+
+    planning.expect(i);
+    ids[n] = i; p[n] = &path[i]; n++;
+  }
+
+  if (n == 0) return;
+
+  for(int k=0; k<n; k++)
+    p[k]->req_deadline = planning.deadline(ids[k], plan_threads.threads());
+
+  plan_threads.solve(p, n);
+
+  for(int k=0; k<n; k++) {
+    planning.finished(ids[k], path[ids[k]]);
+    robot[ids[k]]->finishNav(*this);
+  }
+}
+
+void World::runParallel(void (*fn)(void *arg, int i), void *arg, int n)
+{
+  // The trackers predict lazily, and only reading a prediction already
+  // made is safe from several threads.
+  ball_position();
+  ball_velocity();
+
+  for(int i=0; i<n_teammates; i++) {
+    teammate_position(i);
+    teammate_velocity(i);
+  }
+
+  for(int i=0; i<n_opponents; i++) {
+    opponent_position(i);
+    opponent_velocity(i);
+  }
+
+  plan_threads.run(fn, arg, n);
+}
+
+const WorldSnapshot *World::acquireSnapshot()
+{
+  while(true) {
+    WorldSnapshot *s = published;
+
+    if (!s) return NULL;
+
+    __sync_fetch_and_add(&s->readers, 1);
+
+    // If it's still published the writer can't have picked it.
+    if (s == published) return s;
+
+    __sync_fetch_and_sub(&s->readers, 1);
+  }
+}
+
+void World::releaseSnapshot(const WorldSnapshot *s)
+{
+  if (s) __sync_fetch_and_sub(&((WorldSnapshot *) s)->readers, 1);
 }
 
 void World::updateHighLevel() 
@@ -304,6 +444,11 @@ double World::teammate_angular_velocity(int id, double t)
   return tracker.robots[color][teammate_id_to_index[id]].angular_velocity(t);
 }
 
+double World::teammate_latency(int id)
+{
+  return tracker.robots[color][teammate_id_to_index[id]].get_latency();
+}
+
 double World::teammate_stuck(int id)
 {
   return tracker.robots[color][teammate_id_to_index[id]].stuck(0.0);
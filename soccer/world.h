@@ -32,12 +32,19 @@
 #include <robot_tracker.h>
 
 #include "path_planner.h"
+#include "distance_field.h"
+#include "quality_grid.h"
 
 #include "modeller.h"
 
 #include "commands.h"
 
 class Robot;
+class WorldSnapshot;
+
+// Number of snapshots in rotation.  One is published, the rest are
+// either being read or free to be written.
+#define WORLD_SNAPSHOTS 4
 
 class World {
 private:
@@ -49,8 +56,6 @@ private:
 
   void updateHighLevel();
 
-  Modeller modeller;
-
   double our_dzone_duration;
   double their_dzone_duration;
 
@@ -59,6 +64,17 @@ private:
 
   char last_ref_state;
 
+  WorldSnapshot *snapshots;
+  WorldSnapshot *volatile published;
+  bool snapshots_wanted;
+
+  void publishSnapshot();
+
+  friend class WorldSnapshot;
+
+  plan_pool plan_threads;
+  bool plans_deferred;
+
 public:
   // Constructors & Destructors
   World();
@@ -69,6 +85,43 @@ public:
   // Update
   void update(const net_vframe &f);
 
+  // Snapshots
+  //
+  // An immutable copy of the world is published at the end of every
+  // update().  acquireSnapshot() can be called from any thread and
+  // returns the latest snapshot (or NULL before the first frame).  It
+  // stays valid, even as newer ones are published, until it is
+  // released with releaseSnapshot().
+  //
+  // Snapshots are only published with WORLD_PUBLISH_SNAPSHOTS
+  // (robot.cfg) set, or once something that reads them has asked for
+  // them with wantSnapshots().
+  const WorldSnapshot *acquireSnapshot();
+  void releaseSnapshot(const WorldSnapshot *s);
+  void wantSnapshots() { snapshots_wanted = true; }
+
+  // Planning
+  //
+  // Between collectPlans() and solvePlans() nav_to_point() only posts
+  // each robot's plan request.  solvePlans() then solves them all at
+  // once on PLAN_THREADS threads and has each robot finish its
+  // navigation and send its command.  Outside of these (or with
+  // PLAN_THREADS 0) robots plan one after another as they run.
+  void collectPlans();
+  void solvePlans();
+  bool plansDeferred() { return plans_deferred; }
+
+  // Parallel
+  //
+  // Calls fn(arg, i) for i in [0,n) on the planning threads, which are
+  // free while the tactics run, and returns once all have returned.
+  // The robots and ball are predicted up to now first, so fn may ask
+  // for their positions and velocities at now (time -1), and use what
+  // only reads those, from any thread.
+  void runParallel(void (*fn)(void *arg, int i), void *arg, int n);
+  // including the calling one
+  int planThreads() { return plan_threads.threads(); }
+
   // Team and Side
   char color;
   char side;
@@ -120,6 +173,10 @@ public:
 
   double teammate_stuck(int id);
 
+  // Estimated delay between sending a command and the robot acting
+  // on it.  Predictions of the robot already account for it.
+  double teammate_latency(int id);
+
   void teammate_raw(int id, vraw &vpos);
 
   void teammate_command(int id, double vx, double vy, double va);
@@ -129,9 +186,12 @@ public:
   vector2d opponent_position(int id, double time = -1);
   vector2d opponent_velocity(int id, double time = -1);
   void opponent_raw(int id, vraw &vpos);
+  // The vision slot, which stays with the robot as others come and go.
+  int opponent_vision_id(int id) { return opponent_id_to_index[id]; }
 
   // Game State (from Referee)
   char game_state;
+  char prev_game_state; // game_state the frame before
   char goal_scored; // 1: our goal, -1: their goal, 0: no goal
 
   // Send Command to Robot
@@ -142,6 +202,16 @@ public:
   // Robot internal state
   Robot *robot[MAX_TEAM_ROBOTS];
   path_planner path[MAX_TEAM_ROBOTS];
+  plan_budget planning;
+
+  // walls and defense zones for obstacles::add_static()
+  distance_field static_field;
+
+  // shot and pass quality over the field, updated every frame
+  quality_grid quality;
+
+  // what the opponents tend to do, updated every frame
+  Modeller modeller;
 
   /////////////////////////////////////////////////////////////////
   //
@@ -0,0 +1,200 @@
+// world_snapshot.cc
+//
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#include <stdio.h>
+
+#include "constants.h"
+#include "world_snapshot.h"
+
+void WorldSnapshot::set(World &w)
+{
+  color = w.color;
+  side = w.side;
+  time = w.time;
+  now = w.now;
+
+  // Ball
+  for(int k=0; k<SNAPSHOT_BALL_STEPS; k++) {
+    double t = k * FRAME_PERIOD;
+    Matrix P = w.tracker.ball.covariances(t);
+
+    ball[k].pos = w.tracker.ball.position(t) * side;
+    ball[k].vel = w.tracker.ball.velocity(t) * side;
+    P.CopyData(ball[k].cov);
+  }
+
+  // Robots
+  n_teammates = w.n_teammates;
+  n_opponents = w.n_opponents;
+
+  for(int i=0; i<n_teammates; i++) {
+    RobotTracker &r = w.tracker.robots[(int) color][w.teammate_id_to_index[i]];
+
+    for(int k=0; k<SNAPSHOT_ROBOT_STEPS; k++) {
+      double t = k * FRAME_PERIOD;
+
+      teammates[i][k].pos = r.position(t) * side;
+      teammates[i][k].vel = r.velocity(t) * side;
+      teammates[i][k].vel_raw = r.velocity_raw(t) * side;
+      teammates[i][k].dir =
+	anglemod((side < 0 ? M_PI : 0.0) + r.direction(t));
+      teammates[i][k].angvel = r.angular_velocity(t);
+    }
+
+    teammate_types[i] = w.teammate_type(i);
+    teammate_stucks[i] = w.teammate_stuck(i);
+  }
+
+  for(int i=0; i<n_opponents; i++) {
+    RobotTracker &r = w.tracker.robots[!color][w.opponent_id_to_index[i]];
+
+    for(int k=0; k<SNAPSHOT_ROBOT_STEPS; k++) {
+      double t = k * FRAME_PERIOD;
+
+      opponents[i][k].pos = r.position(t) * side;
+      opponents[i][k].vel = r.velocity(t) * side;
+      opponents[i][k].vel_raw = r.velocity_raw(t) * side;
+      opponents[i][k].dir =
+	anglemod((side < 0 ? M_PI : 0.0) + r.direction(t));
+      opponents[i][k].angvel = r.angular_velocity(t);
+    }
+  }
+
+  // Game State
+  game_state = w.game_state;
+  goal_scored = w.goal_scored;
+
+  // High-Level
+  possession = w.possession;
+  fieldPosition = w.fieldPosition;
+  situation = w.situation;
+  ballXThreshold = w.ballXThreshold;
+  ballYThreshold = w.ballYThreshold;
+
+  orole_goalie = w.orole_goalie;
+  trole_goalie = w.trole_goalie;
+  trole_active = w.trole_active;
+}
+
+int WorldSnapshot::step(double t, int nsteps)
+{
+  int k = (int) rint(t / FRAME_PERIOD);
+
+  if (k < 0) return 0;
+  if (k >= nsteps) return nsteps - 1;
+  return k;
+}
+
+// Returns the tabulated step for time t and, in dt, how far t lies
+// beyond the end of the table.
+const WorldSnapshot::robot_step &WorldSnapshot::robot(const robot_step *s,
+						      double t,
+						      double &dt) const
+{
+  int k = step(t, SNAPSHOT_ROBOT_STEPS);
+
+  dt = t - (SNAPSHOT_ROBOT_STEPS - 1) * FRAME_PERIOD;
+  if (dt < 0.0) dt = 0.0;
+
+  return s[k];
+}
+
+vector2d WorldSnapshot::ball_position(double t) const
+{
+  if (t < 0) t = now;
+
+  int k = step(t, SNAPSHOT_BALL_STEPS);
+  double dt = t - (SNAPSHOT_BALL_STEPS - 1) * FRAME_PERIOD;
+
+  // Past the end of the table just keep rolling.
+  if (dt > 0.0) return ball[k].pos + ball[k].vel * dt;
+  else return ball[k].pos;
+}
+
+vector2d WorldSnapshot::ball_velocity(double t) const
+{
+  if (t < 0) t = now;
+  return ball[step(t, SNAPSHOT_BALL_STEPS)].vel;
+}
+
+Matrix WorldSnapshot::ball_covariances(double t) const
+{
+  if (t < 0) t = now;
+
+  Matrix P(4, 4);
+  const double *cov = ball[step(t, SNAPSHOT_BALL_STEPS)].cov;
+
+  for(int i=0; i<4; i++)
+    for(int j=0; j<4; j++) P.e(i, j) = cov[i * 4 + j];
+
+  return P;
+}
+
+vector2d WorldSnapshot::teammate_position(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  const robot_step &s = robot(teammates[id], t, dt);
+
+  return s.pos + s.vel_raw * dt;
+}
+
+vector2d WorldSnapshot::teammate_velocity(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  return robot(teammates[id], t, dt).vel;
+}
+
+double WorldSnapshot::teammate_direction(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  const robot_step &s = robot(teammates[id], t, dt);
+
+  return anglemod(s.dir + s.angvel * dt);
+}
+
+double WorldSnapshot::teammate_angular_velocity(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  return robot(teammates[id], t, dt).angvel;
+}
+
+vector2d WorldSnapshot::opponent_position(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  const robot_step &s = robot(opponents[id], t, dt);
+
+  return s.pos + s.vel_raw * dt;
+}
+
+vector2d WorldSnapshot::opponent_velocity(int id, double t) const
+{
+  if (t < 0) t = now;
+
+  double dt;
+  return robot(opponents[id], t, dt).vel;
+}
@@ -0,0 +1,118 @@
+// world_snapshot.h
+//
+// An immutable copy of the world's state for a single vision frame.
+// World publishes one at the end of update() when asked, so that code on
+// other threads can query the world without touching the trackers,
+// whose predictions are cached in place and aren't reentrant.
+//
+// Ball predictions are tabulated every FRAME_PERIOD out to
+// SNAPSHOT_BALL_TIME past now, which covers what the trackers would
+// compute.  Robot predictions are tabulated out to now and then
+// extrapolated with the velocity at now, as ROBOT_FAST_PREDICT does.
+//
+/* LICENSE:
+  =========================================================================
+    CMDragons'02 RoboCup F180 Source Code Release
+  -------------------------------------------------------------------------
+    Copyright (C) 2002 Manuela Veloso, Brett Browning, Mike Bowling,
+                       James Bruce; {mmv, brettb, mhb, jbruce}@cs.cmu.edu
+    School of Computer Science, Carnegie Mellon University
+  -------------------------------------------------------------------------
+    This software is distributed under the GNU General Public License,
+    version 2.  If you do not have a copy of this licence, visit
+    www.gnu.org, or write: Free Software Foundation, 59 Temple Place,
+    Suite 330 Boston, MA 02111-1307 USA.  This program is distributed
+    in the hope that it will be useful, but WITHOUT ANY WARRANTY,
+    including MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  ------------------------------------------------------------------------- */
+
+#ifndef __world_snapshot_h__
+#define __world_snapshot_h__
+
+#include "world.h"
+
+#define SNAPSHOT_BALL_TIME 1.0
+#define SNAPSHOT_BALL_STEPS \
+  ((int) ((LATENCY_DELAY + SNAPSHOT_BALL_TIME) / FRAME_PERIOD) + 2)
+#define SNAPSHOT_ROBOT_STEPS ((int) (LATENCY_DELAY / FRAME_PERIOD) + 2)
+
+class WorldSnapshot {
+private:
+  struct ball_step {
+    vector2d pos, vel;
+    double cov[16];
+  };
+
+  struct robot_step {
+    vector2d pos, vel, vel_raw;
+    double dir, angvel;
+  };
+
+  ball_step ball[SNAPSHOT_BALL_STEPS];
+  robot_step teammates[MAX_TEAM_ROBOTS][SNAPSHOT_ROBOT_STEPS];
+  robot_step opponents[MAX_TEAM_ROBOTS][SNAPSHOT_ROBOT_STEPS];
+
+  int teammate_types[MAX_TEAM_ROBOTS];
+  double teammate_stucks[MAX_TEAM_ROBOTS];
+
+  // Number of threads holding this snapshot.  See World::acquireSnapshot().
+  volatile int readers;
+
+  static int step(double t, int nsteps);
+  const robot_step &robot(const robot_step *s, double t, double &dt) const;
+
+  friend class World;
+
+public:
+  WorldSnapshot() { readers = 0; }
+
+  // Copies the state of w, which must have just been updated.
+  void set(World &w);
+
+  // Team and Side
+  char color;
+  char side;
+
+  // Time information (see World)
+  double time;
+  double now;
+
+  // Basic Ball Information
+  vector2d ball_position(double t = -1) const;
+  vector2d ball_velocity(double t = -1) const;
+  Matrix ball_covariances(double t = -1) const;
+
+  // Basic Teammate Information
+  int n_teammates;
+  int teammate_type(int id) const { return teammate_types[id]; }
+  double teammate_radius(int id) const {
+    if (teammate_type(id) == ROBOT_TYPE_DIFF) return DIFFBOT_RADIUS;
+    else return OMNIBOT_RADIUS; }
+  vector2d teammate_position(int id, double t = -1) const;
+  vector2d teammate_velocity(int id, double t = -1) const;
+  double teammate_direction(int id, double t = -1) const;
+  double teammate_angular_velocity(int id, double t = -1) const;
+  double teammate_stuck(int id) const { return teammate_stucks[id]; }
+
+  // Basic Opponent Information
+  int n_opponents;
+  vector2d opponent_position(int id, double t = -1) const;
+  vector2d opponent_velocity(int id, double t = -1) const;
+
+  // Game State
+  char game_state;
+  char goal_scored;
+
+  // High-Level Information (see World)
+  World::Possession possession;
+  World::FieldPosition fieldPosition;
+  World::Situation situation;
+
+  double ballXThreshold, ballYThreshold;
+
+  int orole_goalie;
+  int trole_goalie;
+  int trole_active;
+};
+
+#endif
@@ -38,6 +38,13 @@ CR_DECLARE(BALL_CONFIDENCE_THRESHOLD);
 CR_DECLARE(BALL_OCCLUDE_TIME);
 CR_DECLARE(BALL_LIKELIHOOD_THRESHOLD);
 
+CR_DECLARE(BALL_HYPOTHESES);
+CR_DECLARE(BALL_HYPOTHESIS_SPAWN_WEIGHT);
+CR_DECLARE(BALL_HYPOTHESIS_PRUNE_WEIGHT);
+CR_DECLARE(BALL_HYPOTHESIS_KICK_DISTANCE);
+CR_DECLARE(BALL_HYPOTHESIS_COLLISION_MARGIN);
+CR_DECLARE(BALL_HYPOTHESIS_VELOCITY_VARIANCE);
+
 //
 // State = ( x, y, v_x, v_y )
 // Observation = ( x, y )
@@ -52,6 +59,9 @@ BallTracker::BallTracker() : Kalman(4, 2, FRAME_PERIOD)
   occluded = Visible;
   tracker = NULL;
 
+  hypotheses_enabled = true;
+  hypotheses_clear();
+
   if (!cr_setup) {
     CR_SETUP(tracker, BALL_WALLS_SLOPED, CR_INT);
     CR_SETUP(tracker, BALL_WALLS_OOB, CR_INT);
@@ -68,6 +78,13 @@ BallTracker::BallTracker() : Kalman(4, 2, FRAME_PERIOD)
     CR_SETUP(tracker, BALL_OCCLUDE_TIME, CR_DOUBLE);
     CR_SETUP(tracker, BALL_LIKELIHOOD_THRESHOLD, CR_DOUBLE);
 
+    CR_SETUP(tracker, BALL_HYPOTHESES, CR_INT);
+    CR_SETUP(tracker, BALL_HYPOTHESIS_SPAWN_WEIGHT, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_HYPOTHESIS_PRUNE_WEIGHT, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_HYPOTHESIS_KICK_DISTANCE, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_HYPOTHESIS_COLLISION_MARGIN, CR_DOUBLE);
+    CR_SETUP(tracker, BALL_HYPOTHESIS_VELOCITY_VARIANCE, CR_DOUBLE);
+
     cr_setup = true;
   }
 
@@ -230,6 +247,7 @@ void BallTracker::observe(vraw obs, double timestamp)
     P.e(3,3) *= 250000.0; // 500m/s
 
     initial(obs.timestamp, x, P);
+    hypotheses_clear();
 
     occluded = Visible;
 
@@ -263,7 +281,8 @@ void BallTracker::observe(vraw obs, double timestamp)
       // Make observation
       if (obs.timestamp == timestamp && 
 	  obs.conf > DVAR(BALL_CONFIDENCE_THRESHOLD)) {
-	update(o);
+	if (max_hypotheses() > 0) update_hypotheses(o, timestamp);
+	else update(o);
 	
 	occluded = Visible;
 	occluded_last_obs_time = obs.timestamp;
@@ -278,10 +297,11 @@ void BallTracker::observe(vraw obs, double timestamp)
 
 	  occluded = Occluded;
 	  _reset = true;
+	  hypotheses_clear();
 	}
       }
 
-      if (error_time_elapsed() > 10.0) {
+      if (IVAR(BALL_PRINT_KALMAN_ERROR) && error_time_elapsed() > 10.0) {
 	fprintf(stderr, "Kalman Error (pos, vpos): ");
 	fprintf(stderr, "%f ", 
 		hypot(error_mean().e(0, 0), error_mean().e(1, 0)));
@@ -302,6 +322,7 @@ void BallTracker::reset(double timestamp, float state[4], float variances[16],
   Matrix x(4,1,state), P(4,4,variances);
 
   initial(timestamp, x, P);
+  hypotheses_clear();
   
   occluded = _occluded;
   occluding_team = _occluding_team;
@@ -329,7 +350,12 @@ vector2d BallTracker::velocity(double time)
 
 Matrix BallTracker::covariances(double time)
 {  
-  return predict_cov(time);
+  Matrix P = predict_cov(time);
+
+  // Account for the spread of the other hypotheses.
+  if (n_hyps > 0) P = P + hyps_spread;
+
+  return P;
 }
 
 bool BallTracker::collision(double time, int &team, int &robot) 
@@ -348,6 +374,284 @@ bool BallTracker::collision(double time, int &team, int &robot)
 #define MIN(a,b) ((a<b) ? a : b)
 #endif
 
+//
+// Multiple Hypotheses
+//
+// The alternatives use the same linear model as the main filter but
+// without collision prediction, since each one already commits to
+// what the ball just hit.
+//
+
+int BallTracker::max_hypotheses()
+{
+  if (!hypotheses_enabled) return 0;
+  return MIN(IVAR(BALL_HYPOTHESES), MAX_BALL_HYPOTHESES);
+}
+
+void BallTracker::hypotheses_clear()
+{
+  n_hyps = 0;
+  main_weight = 1.0;
+  last_obs_valid = false;
+
+  hyps_spread = Matrix(4, 4);
+  for(int i=0; i<4; i++)
+    for(int j=0; j<4; j++) hyps_spread.e(i, j) = 0.0;
+}
+
+void BallTracker::hypothesis_propagate(Matrix &x, Matrix &P, double dt)
+{
+  int nsteps = (int) rint(dt / stepsize);
+  Matrix &_A = A(x);
+  Matrix &_W = W(x);
+
+  for(int i=0; i<nsteps; i++) {
+    double &_x = x.e(0,0), &_y = x.e(1,0), &_vx = x.e(2,0), &_vy = x.e(3,0);
+    double _v = sqrt(_vx * _vx + _vy * _vy);
+
+    double _a = MIN(DVAR(BALL_FRICTION) * GRAVITY, _v / stepsize);
+    double _ax = (_v == 0.0) ? 0.0 : -_a * _vx / _v;
+    double _ay = (_v == 0.0) ? 0.0 : -_a * _vy / _v;
+
+    _x += _vx * stepsize + 0.5 * _ax * stepsize * stepsize;
+    _y += _vy * stepsize + 0.5 * _ay * stepsize * stepsize;
+    _vx += _ax * stepsize;
+    _vy += _ay * stepsize;
+
+    Matrix &_Q = Q(x);
+    P = _A * P * transpose(_A) + _W * _Q * transpose(_W);
+  }
+}
+
+// Returns the (normalized) likelihood of observation z, and the
+// squared Mahalanobis distance of z from the prediction in mdist.
+double BallTracker::hypothesis_likelihood(const Matrix &x, const Matrix &P,
+					  const Matrix &z, double &mdist)
+{
+  Matrix &_H = H(x);
+  Matrix C = _H * P * transpose(_H) + R(x);
+  Matrix D = z - h(x);
+  Matrix M = transpose(D) * inverse(C) * D;
+
+  double det = C.e(0, 0) * C.e(1, 1) - C.e(0, 1) * C.e(1, 0);
+
+  mdist = M.e(0, 0);
+  if (det <= 0.0) return 0.0;
+
+  return exp(-0.5 * mdist) / (2.0 * M_PI * sqrt(det));
+}
+
+void BallTracker::hypothesis_update(Matrix &x, Matrix &P, const Matrix &z)
+{
+  Matrix &_H = H(x);
+  Matrix &_V = V(x);
+  Matrix &_R = R(x);
+
+  Matrix K = P * transpose(_H) * 
+    inverse(_H * P * transpose(_H) + _V * _R * transpose(_V));
+
+  x = x + K * (z - h(x));
+  P = (Matrix(P.nrows()) - K * _H) * P;
+}
+
+void BallTracker::hypothesis_add(HypothesisType type, int team, int robot,
+				 double weight, 
+				 const Matrix &x, const Matrix &P)
+{
+  int i = n_hyps;
+
+  // When full, replace the least likely hypothesis if this is better.
+  if (n_hyps >= max_hypotheses()) {
+    if (n_hyps == 0) return;
+
+    i = 0;
+    for(int j=1; j<n_hyps; j++)
+      if (hyps[j].weight < hyps[i].weight) i = j;
+
+    if (hyps[i].weight >= weight) return;
+  } else n_hyps++;
+
+  hyps[i].type = type;
+  hyps[i].team = team;
+  hyps[i].robot = robot;
+  hyps[i].weight = weight;
+  hyps[i].x = x;
+  hyps[i].P = P;
+}
+
+void BallTracker::hypotheses_spawn(const Matrix &z, double timestamp, 
+				   double mdist)
+{
+  vector2d b(z.e(0, 0), z.e(1, 0));
+  bool kicked = false;
+
+  Matrix x(4,1), P(4);
+
+  x.e(0,0) = b.x;
+  x.e(1,0) = b.y;
+
+  P.e(0,0) *= DVAR(BALL_POSITION_VARIANCE);
+  P.e(1,1) *= DVAR(BALL_POSITION_VARIANCE);
+  P.e(2,2) *= DVAR(BALL_HYPOTHESIS_VELOCITY_VARIANCE);
+  P.e(3,3) *= DVAR(BALL_HYPOTHESIS_VELOCITY_VARIANCE);
+
+  for(int i=0; i<n_hyps; i++)
+    if (hyps[i].type == Kicked) kicked = true;
+
+  // Kicked: the observation is far from where the main filter
+  // expected it.  Start with the velocity between the last two
+  // observations.
+  if (!kicked && mdist > DVAR(BALL_HYPOTHESIS_KICK_DISTANCE) &&
+      last_obs_valid && timestamp > last_obs_time) {
+    vector2d v = (b - last_obs) / (timestamp - last_obs_time);
+
+    x.e(2,0) = v.x;
+    x.e(3,0) = v.y;
+
+    hypothesis_add(Kicked, -1, -1, DVAR(BALL_HYPOTHESIS_SPAWN_WEIGHT), x, P);
+  }
+
+  if (!tracker) return;
+
+  // Collided: the ball is within reach of a robot and may now be
+  // moving with it.
+  for(int i = 0; i < NUM_TEAMS; i++) {
+    for(int j = 0; j < MAX_TEAM_ROBOTS; j++) {
+      if (!tracker->Exists(i, j)) continue;
+
+      double radius;
+      
+      switch(tracker->Type(i, j)) {
+      case ROBOT_TYPE_DIFF:
+      case ROBOT_TYPE_OMNI:
+	radius = DVAR(BALL_TEAMMATE_COLLISION_RADIUS); break;
+      default:
+	radius = DVAR(BALL_OPPONENT_COLLISION_RADIUS); break;
+      }
+
+      if (radius <= 0) continue;
+
+      vector2d p = tracker->robots[i][j].position(0.0);
+      if ((p - b).length() > radius + DVAR(BALL_HYPOTHESIS_COLLISION_MARGIN))
+	continue;
+
+      bool exists = false;
+      for(int k=0; k<n_hyps; k++)
+	if (hyps[k].type == Collided && 
+	    hyps[k].team == i && hyps[k].robot == j) exists = true;
+      if (exists) continue;
+
+      vector2d v = tracker->robots[i][j].velocity(0.0);
+
+      x.e(2,0) = v.x;
+      x.e(3,0) = v.y;
+
+      hypothesis_add(Collided, i, j, DVAR(BALL_HYPOTHESIS_SPAWN_WEIGHT), x, P);
+    }
+  }
+}
+
+void BallTracker::hypotheses_mixture()
+{
+  Matrix x0 = predict(0.0);
+  Matrix P0 = predict_cov(0.0);
+  double mean[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double total = main_weight;
+
+  for(int k=0; k<n_hyps; k++) total += hyps[k].weight;
+  if (total <= 0.0) return;
+
+  for(int k=-1; k<n_hyps; k++) {
+    const Matrix &x = (k < 0) ? x0 : hyps[k].x;
+    double w = ((k < 0) ? main_weight : hyps[k].weight) / total;
+
+    for(int i=0; i<4; i++) mean[i] += w * x.e(i, 0);
+  }
+
+  for(int i=0; i<4; i++)
+    for(int j=0; j<4; j++) hyps_spread.e(i, j) = -P0.e(i, j);
+
+  for(int k=-1; k<n_hyps; k++) {
+    const Matrix &x = (k < 0) ? x0 : hyps[k].x;
+    const Matrix &P = (k < 0) ? P0 : hyps[k].P;
+    double w = ((k < 0) ? main_weight : hyps[k].weight) / total;
+
+    for(int i=0; i<4; i++)
+      for(int j=0; j<4; j++)
+	hyps_spread.e(i, j) += w * (P.e(i, j) + 
+				    (x.e(i, 0) - mean[i]) * 
+				    (x.e(j, 0) - mean[j]));
+  }
+}
+
+void BallTracker::update_hypotheses(const Matrix &z, double timestamp)
+{
+  double mdist, d;
+  double total;
+
+  // Weigh the main filter and the alternatives by the likelihood of
+  // the observation, then fold the observation into each.
+  main_weight *= hypothesis_likelihood(predict(0.0), predict_cov(0.0), 
+				       z, mdist);
+  total = main_weight;
+
+  for(int i=0; i<n_hyps; i++) {
+    hypothesis_propagate(hyps[i].x, hyps[i].P, timestamp - hyps_time);
+    hyps[i].weight *= hypothesis_likelihood(hyps[i].x, hyps[i].P, z, d);
+    hypothesis_update(hyps[i].x, hyps[i].P, z);
+    total += hyps[i].weight;
+  }
+
+  hyps_time = timestamp;
+
+  update(z);
+
+  if (total <= 0.0) {
+    // Nothing explains the observation.  Trust the main filter.
+    hypotheses_clear();
+
+  } else {
+    main_weight /= total;
+
+    for(int i=0; i<n_hyps; i++) {
+      hyps[i].weight /= total;
+
+      if (hyps[i].weight < DVAR(BALL_HYPOTHESIS_PRUNE_WEIGHT)) {
+	hyps[i] = hyps[--n_hyps]; i--;
+      }
+    }
+
+    // Switch to the best alternative if it beats the main filter.
+    int best = -1;
+
+    for(int i=0; i<n_hyps; i++)
+      if (hyps[i].weight > main_weight &&
+	  (best < 0 || hyps[i].weight > hyps[best].weight)) best = i;
+
+    if (best >= 0) {
+      hypothesis old;
+
+      old.type = Rolling;
+      old.team = old.robot = -1;
+      old.weight = main_weight;
+      old.x = predict(0.0);
+      old.P = predict_cov(0.0);
+
+      initial(timestamp, hyps[best].x, hyps[best].P);
+
+      main_weight = hyps[best].weight;
+      hyps[best] = old;
+    }
+  }
+
+  hypotheses_spawn(z, timestamp, mdist);
+  hypotheses_mixture();
+
+  last_obs = vector2d(z.e(0, 0), z.e(1, 0));
+  last_obs_time = timestamp;
+  last_obs_valid = true;
+}
+
 Matrix& BallTracker::f(const Matrix &x, Matrix &I)
 {
   I = Matrix();
@@ -22,6 +22,8 @@
 
 class VTracker;
 
+#define MAX_BALL_HYPOTHESES 8
+
 class BallTracker : private Kalman {
 public:
   enum OccludeFlag { Visible, MaybeOccluded, Occluded };
@@ -51,6 +53,48 @@ private:
   vector2d occluding_offset;
   double occluded_last_obs_time;
 
+  // Multiple Hypotheses
+  //
+  // Alternative explanations of the ball's motion (it was just kicked,
+  // or it bounced off a particular robot) are propagated alongside the
+  // main filter and weighted by how well they explain observations.
+  // If an alternative becomes more likely than the main filter, the
+  // filter is reseeded from it and the old estimate becomes a
+  // free-rolling alternative.
+  enum HypothesisType { Rolling, Collided, Kicked };
+
+  struct hypothesis {
+    HypothesisType type;
+    char team, robot;
+    double weight;
+    Matrix x, P;
+  };
+
+  bool hypotheses_enabled;
+  hypothesis hyps[MAX_BALL_HYPOTHESES];
+  int n_hyps;
+  double hyps_time;
+  double main_weight;
+
+  // Mixture covariance minus the covariance of the best hypothesis.
+  Matrix hyps_spread;
+
+  bool last_obs_valid;
+  vector2d last_obs;
+  double last_obs_time;
+
+  int max_hypotheses();
+  void hypotheses_clear();
+  void hypothesis_propagate(Matrix &x, Matrix &P, double dt);
+  double hypothesis_likelihood(const Matrix &x, const Matrix &P, 
+			       const Matrix &z, double &mdist);
+  void hypothesis_update(Matrix &x, Matrix &P, const Matrix &z);
+  void hypothesis_add(HypothesisType type, int team, int robot,
+		      double weight, const Matrix &x, const Matrix &P);
+  void hypotheses_spawn(const Matrix &z, double timestamp, double mdist);
+  void hypotheses_mixture();
+  void update_hypotheses(const Matrix &z, double timestamp);
+
   friend VTracker;
 
 protected:
@@ -71,6 +115,17 @@ public:
 
   void set_tracker(VTracker *t) { tracker = t; }
 
+  // Turns the hypothesis bank on or off independent of
+  // BALL_HYPOTHESES (e.g. for comparing both in the same process).
+  void set_hypotheses(bool on) { hypotheses_enabled = on; hypotheses_clear(); }
+  int num_hypotheses() { return n_hyps; }
+
+  // Mean absolute error of predictions dt seconds ahead against the
+  // filtered state (see Kalman::error_mean()).
+  void set_error_lookahead(double dt) { error_lookahead(dt); }
+  Matrix prediction_error() { return error_mean(); }
+  int prediction_error_count() { return error_count(); }
+
   void reset() { _reset = true; }
   void reset(double timestamp, float state[4], float variances[16],
 	     OccludeFlag occluded, 
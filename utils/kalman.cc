@@ -39,6 +39,7 @@ Kalman::Kalman(int _state_n, int _obs_n, double _stepsize) {
   prediction_lookahead = 0.0;
   prediction_time = 0.0;
   errors = Matrix(_state_n, 1);
+  error_reset();
 }
 
 void Kalman::initial(double t, Matrix &x, Matrix &P)
@@ -224,9 +225,17 @@ double Kalman::obs_likelihood(double dt, Matrix &z)
   return likelihood;
 }
 
+void Kalman::error_lookahead(double dt)
+{
+  prediction_lookahead = dt;
+  prediction_time = 0.0;
+  error_reset();
+}
+
 Matrix Kalman::error_mean()
 {
-  return errors.scale(1.0 / (double) errors_n);
+  Matrix mean = errors;
+  return mean.scale(1.0 / (double) errors_n);
 }
 
 void Kalman::error_reset()
@@ -84,9 +84,11 @@ public:
 
   double obs_likelihood(double dt, Matrix &z);
 
+  void error_lookahead(double dt);
   Matrix error_mean();
   void error_reset();
   double error_time_elapsed();
+  int error_count() { return errors_n; }
 };
 
 #endif
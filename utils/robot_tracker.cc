@@ -41,6 +41,13 @@ CR_DECLARE(ROBOT_STUCK_VARIANCE);
 CR_DECLARE(ROBOT_VELOCITY_NEXT_STEP_COVARIANCE);
 CR_DECLARE(ROBOT_STUCK_DECAY);
 CR_DECLARE(ROBOT_STUCK_THRESHOLD);
+CR_DECLARE(ROBOT_ESTIMATE_LATENCY);
+CR_DECLARE(ROBOT_LATENCY_MIN);
+CR_DECLARE(ROBOT_LATENCY_MAX);
+CR_DECLARE(ROBOT_LATENCY_SAMPLES);
+CR_DECLARE(ROBOT_LATENCY_MIN_SPEED);
+CR_DECLARE(ROBOT_LATENCY_MIN_CORRELATION);
+CR_DECLARE(ROBOT_LATENCY_GAIN);
 
 //
 // State = ( x, y, theta, v_par, v_perp, v_theta, stuck )
@@ -71,6 +78,13 @@ RobotTracker::RobotTracker(int _type, double _latency)
     CR_SETUP(tracker, ROBOT_VELOCITY_NEXT_STEP_COVARIANCE, CR_DOUBLE);
     CR_SETUP(tracker, ROBOT_STUCK_DECAY, CR_DOUBLE);
     CR_SETUP(tracker, ROBOT_STUCK_THRESHOLD, CR_DOUBLE);
+    CR_SETUP(tracker, ROBOT_ESTIMATE_LATENCY, CR_INT);
+    CR_SETUP(tracker, ROBOT_LATENCY_MIN, CR_DOUBLE);
+    CR_SETUP(tracker, ROBOT_LATENCY_MAX, CR_DOUBLE);
+    CR_SETUP(tracker, ROBOT_LATENCY_SAMPLES, CR_INT);
+    CR_SETUP(tracker, ROBOT_LATENCY_MIN_SPEED, CR_DOUBLE);
+    CR_SETUP(tracker, ROBOT_LATENCY_MIN_CORRELATION, CR_DOUBLE);
+    CR_SETUP(tracker, ROBOT_LATENCY_GAIN, CR_DOUBLE);
     cr_setup = true;
   }
 
@@ -78,40 +92,148 @@ RobotTracker::RobotTracker(int _type, double _latency)
   latency = _latency;
   reset_on_obs = 1;
 
+  cs_start = cs_n = 0;
+  vs_start = vs_n = 0;
+  last_raw.timestamp = 0.0;
+  last_raw.conf = 0.0;
+
   if (IVAR(ROBOT_PRINT_KALMAN_ERROR)) 
     prediction_lookahead = LATENCY_DELAY;
 }
 
-RobotTracker::rcommand RobotTracker::get_command(double time)
+// Returns the index of the last command sent at or before time, or -1.
+int RobotTracker::find_command(double time)
 {
-  if (cs.empty() || cs[0].timestamp > time)
-    return (rcommand) { 0.0, vector3d(0.0, 0.0, 0.0) };
+  int lo = 0, hi = cs_n;
 
-  uint i;
+  while(lo < hi) {
+    int mid = (lo + hi) / 2;
 
-  for(i = 1; i < cs.size(); i++) {
-    if (cs[i].timestamp > time) break;
+    if (cs_at(mid).timestamp <= time) lo = mid + 1;
+    else hi = mid;
   }
-  
-  return cs[i-1];
 
+  return lo - 1;
+}
+
+// Returns the command in effect at time, i.e. the last command sent
+// at least latency earlier.
+RobotTracker::rcommand RobotTracker::get_command(double time)
+{
+  int i = find_command(time - latency + (FRAME_PERIOD / 2.0));
+
+  if (i < 0) return (rcommand) { 0.0, vector3d(0.0, 0.0, 0.0) };
+
+  return cs_at(i);
 }
 
 void RobotTracker::command(double timestamp, vector3d vs)
 {
-  rcommand c = { timestamp + latency - (FRAME_PERIOD / 2.0), vs };
+  rcommand c = { timestamp, vs };
+
+  // Replace any commands at or after this one.
+  while(cs_n > 0 && cs_at(cs_n - 1).timestamp >= c.timestamp)
+    cs_n--;
+
+  if (cs_n == MAX_ROBOT_COMMANDS) {
+    cs_start = (cs_start + 1) % MAX_ROBOT_COMMANDS;
+    cs_n--;
+  }
+
+  cs_at(cs_n++) = c;
+}
+
+void RobotTracker::observe_latency(vraw obs)
+{
+  if (obs.conf <= 0.0) return;
+  if (obs.timestamp <= last_raw.timestamp) return;
+
+  double dt = obs.timestamp - last_raw.timestamp;
+
+  if (last_raw.conf > 0.0 && dt < 3.0 * FRAME_PERIOD) {
+    double a = last_raw.angle + anglemod(obs.angle - last_raw.angle) / 2.0;
+    vector2d v = vector2d(obs.pos.x - last_raw.pos.x,
+			  obs.pos.y - last_raw.pos.y) / dt;
+
+    if (vs_n == MAX_ROBOT_VSAMPLES) {
+      vs_start = (vs_start + 1) % MAX_ROBOT_VSAMPLES;
+      vs_n--;
+    }
+
+    vsample &s = vs_at(vs_n++);
+    s.timestamp = obs.timestamp - dt / 2.0;
+    s.v = v.rotate(-a);
+
+    estimate_latency();
+  }
+
+  last_raw = obs;
+}
+
+// Normalized cross-correlation of the observed velocities with the
+// commands sent l seconds earlier.  Returns -2 if there isn't enough
+// data or the robot hasn't been moving.
+double RobotTracker::latency_correlation(double l)
+{
+  vector2d ma(0, 0), mb(0, 0);
+  vector2d b[MAX_ROBOT_VSAMPLES];
+  bool valid[MAX_ROBOT_VSAMPLES];
+  int n = 0;
+
+  for(int i=0; i<vs_n; i++) {
+    int j = find_command(vs_at(i).timestamp - l);
+
+    valid[i] = (j >= 0);
+    if (!valid[i]) continue;
 
-  while(cs.size() > 1 && cs[0].timestamp < time - stepsize)
-    cs.pop_front();
+    b[i] = vector2d(cs_at(j).vs.x, cs_at(j).vs.y);
+    ma += vs_at(i).v; mb += b[i]; n++;
+  }
+
+  if (n < IVAR(ROBOT_LATENCY_SAMPLES)) return -2.0;
+
+  ma /= n; mb /= n;
 
-  while(!cs.empty() && cs.back().timestamp == c.timestamp)
-    cs.pop_back();
+  double sab = 0.0, saa = 0.0, sbb = 0.0;
+
+  for(int i=0; i<vs_n; i++) {
+    if (!valid[i]) continue;
+
+    vector2d da = vs_at(i).v - ma, db = b[i] - mb;
+    sab += da.dot(db);
+    saa += da.dot(da);
+    sbb += db.dot(db);
+  }
 
-  cs.push_back(c);
+  double min_var = n * DVAR(ROBOT_LATENCY_MIN_SPEED) * 
+    DVAR(ROBOT_LATENCY_MIN_SPEED);
+
+  if (saa < min_var || sbb < min_var) return -2.0;
+
+  return sab / sqrt(saa * sbb);
+}
+
+void RobotTracker::estimate_latency()
+{
+  if (!IVAR(ROBOT_ESTIMATE_LATENCY) || type == ROBOT_TYPE_NONE) return;
+
+  double best_l = latency, best_c = -2.0;
+
+  for(double l = DVAR(ROBOT_LATENCY_MIN); l <= DVAR(ROBOT_LATENCY_MAX);
+      l += FRAME_PERIOD / 4.0) {
+    double c = latency_correlation(l);
+    if (c > best_c) { best_c = c; best_l = l; }
+  }
+
+  if (best_c < DVAR(ROBOT_LATENCY_MIN_CORRELATION)) return;
+
+  latency += DVAR(ROBOT_LATENCY_GAIN) * (best_l - latency);
 }
 
 void RobotTracker::observe(vraw obs, double timestamp)
 {
+  if (obs.timestamp == timestamp) observe_latency(obs);
+
   if (reset_on_obs) {
     if (obs.conf <= 0.0) return;
 
@@ -158,7 +280,7 @@ void RobotTracker::observe(vraw obs, double timestamp)
 	update(o);
       }
 
-      if (error_time_elapsed() > 10.0) {
+      if (IVAR(ROBOT_PRINT_KALMAN_ERROR) && error_time_elapsed() > 10.0) {
 	fprintf(stderr, "Kalman Error (pos, theta, vpos, vtheta): ");
 	fprintf(stderr, "%f ", 
 		hypot(error_mean().e(0, 0), error_mean().e(1, 0)));
@@ -20,6 +20,9 @@
 #include <reality/net_vision.h>
 #include "kalman.h"
 
+#define MAX_ROBOT_COMMANDS 64
+#define MAX_ROBOT_VSAMPLES 64
+
 class RobotTracker : private Kalman {
 private:
   int type;
@@ -32,10 +35,33 @@ private:
     vector3d vs;
   };
 
-  deque<rcommand> cs; // Velocity commands
+  // Velocity commands, a ring ordered by the time they were sent.
+  // Latency is applied when looking them up.
+  rcommand cs[MAX_ROBOT_COMMANDS];
+  int cs_start, cs_n;
 
+  rcommand &cs_at(int i) { return cs[(cs_start + i) % MAX_ROBOT_COMMANDS]; }
+  int find_command(double time);
   rcommand get_command(double time);
 
+  // Latency Estimation
+  //
+  // Velocities from consecutive raw observations (in the robot's
+  // frame) are cross-correlated with the commands sent to find the
+  // delay that best lines them up.
+  struct vsample {
+    double timestamp;
+    vector2d v;
+  };
+
+  vsample vsamples[MAX_ROBOT_VSAMPLES];
+  int vs_start, vs_n;
+  vraw last_raw;
+
+  vsample &vs_at(int i) { return vsamples[(vs_start + i) % MAX_ROBOT_VSAMPLES]; }
+  double latency_correlation(double l);
+  void estimate_latency();
+
 protected:
   virtual Matrix& f(const Matrix &x, Matrix &I); // noiseless dynamics
   virtual Matrix& h(const Matrix &x); // noiseless observation
@@ -58,9 +84,21 @@ public:
   void reset() { reset_on_obs = true; }
   void reset(double timestamp, float state[6]);
 
+  // Mean absolute error of predictions dt seconds ahead against the
+  // filtered state (see Kalman::error_mean()).
+  void set_error_lookahead(double dt) { error_lookahead(dt); }
+  Matrix prediction_error() { return error_mean(); }
+  int prediction_error_count() { return error_count(); }
+
   void observe(vraw obs, double timestamp);
   void command(double timestamp, vector3d vs);
 
+  // Feeds a raw observation to the latency estimator only.  observe()
+  // does this itself; this is for users that reset() from filtered
+  // states instead.
+  void observe_latency(vraw obs);
+  double get_latency() { return latency; }
+
   vector2d position(double time);
   vector2d velocity(double time);
   vector2d velocity_raw(double time);
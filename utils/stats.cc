@@ -40,9 +40,16 @@ FrameStats::FrameStats(double _window, bool _verbose)
 
   CR_SETUP(gui, STATS_VISION_CONF, CR_DOUBLE);
 
+  samples = new sample[STATS_MAX_FRAMES];
+  start = n = 0;
+
   // zero everything out
+  memset(v_mean, 0, sizeof(v_mean));
+  memset(v_m2, 0, sizeof(v_m2));
+  memset(a_mean, 0, sizeof(a_mean));
+  memset(miss_mean, 0, sizeof(miss_mean));
+
   memset(&mean, 0, sizeof(mean));
-  memset(&sqmean, 0, sizeof(sqmean));
   memset(&variances, 0, sizeof(variances));
   memset(&maxframe, 0, sizeof(maxframe));
   memset(&maxacc, 0, sizeof(maxacc));
@@ -51,167 +58,117 @@ FrameStats::FrameStats(double _window, bool _verbose)
   memset(&missing, 0, sizeof(missing));
 }
 
-inline void FrameStats::AddVal(double &val, double add, double n)
-{
-  val = (n * val + add) / (n + 1.0);
-}
-
-inline void FrameStats::SubVal(double &val, double sub, double n)
-{
-  val = (n * val - sub) / (n - 1.0);
-}
-
-inline void FrameStats::AddVal(float &val, float add, double _n)
-{
-  float n = (float) _n;
-  val = (n * val + add) / (n + 1.0);
-}
-
-inline void FrameStats::SubVal(float &val, float sub, double _n)
-{
-  float n = (float) _n;
-  val = (n * val - sub) / (n - 1.0);
-}
-
-inline void FrameStats::AddVal(vector2f &val, vector2f add, double _n)
-{
-  float n = (float) _n;
-  val = (val * n + add) / (n + 1.0);
-}
-
-inline void FrameStats::SubVal(vector2f &val, vector2f sub, double _n)
+void FrameStats::Pack(net_vframe &f, float *v)
 {
-  float n = (float) _n;
-  val = (val * n - sub) / (n - 1.0);
-}
-
-
-inline void FrameStats::AddVal(vraw &val, vraw add, double n)
-{
-  AddVal(val.conf, add.conf, n);
-  AddVal(val.angle, add.angle, n);
-  AddVal(val.pos, add.pos, n);
-}
-
-inline void FrameStats::SubVal(vraw &val, vraw sub, double n)
-{
-  SubVal(val.conf, sub.conf, n);
-  SubVal(val.angle, sub.angle, n);
-  SubVal(val.pos, sub.pos, n);
-}
-
-void FrameStats::AddVal(net_vframe &val, net_vframe add, double n)
-{
-  AddVal(val.ball.vision, add.ball.vision, n);
-  AddVal(val.ball.state.x, add.ball.state.x, n);
-  AddVal(val.ball.state.y, add.ball.state.y, n);
-  AddVal(val.ball.state.vx, add.ball.state.vx, n);
-  AddVal(val.ball.state.vy, add.ball.state.vy, n);
+  *v++ = f.ball.vision.conf;
+  *v++ = f.ball.vision.angle;
+  *v++ = f.ball.vision.pos.x;
+  *v++ = f.ball.vision.pos.y;
+  *v++ = f.ball.state.x;
+  *v++ = f.ball.state.y;
+  *v++ = f.ball.state.vx;
+  *v++ = f.ball.state.vy;
 
   for (int t = 0; t < NUM_TEAMS; t++) {
     for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      AddVal(val.robots[t][i].vision, add.robots[t][i].vision, n);
-      AddVal(val.robots[t][i].state.x, add.robots[t][i].state.x, n);
-      AddVal(val.robots[t][i].state.y, add.robots[t][i].state.y, n);
-      AddVal(val.robots[t][i].state.theta, add.robots[t][i].state.theta, n);
-      AddVal(val.robots[t][i].state.vx, add.robots[t][i].state.vx, n);
-      AddVal(val.robots[t][i].state.vy, add.robots[t][i].state.vy, n);
-      AddVal(val.robots[t][i].state.vtheta, add.robots[t][i].state.vtheta, n);
-      AddVal(val.robots[t][i].state.stuck, add.robots[t][i].state.stuck, n);
+      vrobot &r = f.robots[t][i];
+
+      *v++ = r.vision.conf;
+      *v++ = r.vision.angle;
+      *v++ = r.vision.pos.x;
+      *v++ = r.vision.pos.y;
+      *v++ = r.state.x;
+      *v++ = r.state.y;
+      *v++ = r.state.theta;
+      *v++ = r.state.vx;
+      *v++ = r.state.vy;
+      *v++ = r.state.vtheta;
+      *v++ = r.state.stuck;
     }
   }
 }
 
-void FrameStats::SubVal(net_vframe &val, net_vframe sub, double n)
+void FrameStats::Unpack(double *v, net_vframe &f)
 {
-  SubVal(val.ball.vision, sub.ball.vision, n);
-  SubVal(val.ball.state.x, sub.ball.state.x, n);
-  SubVal(val.ball.state.y, sub.ball.state.y, n);
-  SubVal(val.ball.state.vx, sub.ball.state.vx, n);
-  SubVal(val.ball.state.vy, sub.ball.state.vy, n);
+  f.ball.vision.conf = *v++;
+  f.ball.vision.angle = *v++;
+  f.ball.vision.pos.x = *v++;
+  f.ball.vision.pos.y = *v++;
+  f.ball.state.x = *v++;
+  f.ball.state.y = *v++;
+  f.ball.state.vx = *v++;
+  f.ball.state.vy = *v++;
+
   for (int t = 0; t < NUM_TEAMS; t++) {
     for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      SubVal(val.robots[t][i].vision, sub.robots[t][i].vision, n);
-      SubVal(val.robots[t][i].state.x, sub.robots[t][i].state.x, n);
-      SubVal(val.robots[t][i].state.y, sub.robots[t][i].state.y, n);
-      SubVal(val.robots[t][i].state.theta, sub.robots[t][i].state.theta, n);
-      SubVal(val.robots[t][i].state.vx, sub.robots[t][i].state.vx, n);
-      SubVal(val.robots[t][i].state.vy, sub.robots[t][i].state.vy, n);
-      SubVal(val.robots[t][i].state.vtheta, sub.robots[t][i].state.vtheta, n);
-      SubVal(val.robots[t][i].state.stuck, sub.robots[t][i].state.stuck, n);
+      vrobot &r = f.robots[t][i];
+
+      r.vision.conf = *v++;
+      r.vision.angle = *v++;
+      r.vision.pos.x = *v++;
+      r.vision.pos.y = *v++;
+      r.state.x = *v++;
+      r.state.y = *v++;
+      r.state.theta = *v++;
+      r.state.vx = *v++;
+      r.state.vy = *v++;
+      r.state.vtheta = *v++;
+      r.state.stuck = *v++;
     }
   }
 }
 
-inline void FrameStats::SquareVal(vraw &val)
-{
-  val.pos.x *= val.pos.x;
-  val.pos.y *= val.pos.y;
-  val.angle *= val.angle;
-  val.conf *= val.conf;
-}
-
-void FrameStats::SquareVal(net_vframe &val)
+// Adds a sample to the running statistics.  The loops run over the
+// whole packed frame with no per-field branching so the compiler can
+// vectorize them.
+void FrameStats::Add(sample &s)
 {
-  SquareVal(val.ball.vision);
-  val.ball.state.x *= val.ball.state.x;
-  val.ball.state.y *= val.ball.state.y;
-  val.ball.state.vx *= val.ball.state.vx;
-  val.ball.state.vy *= val.ball.state.vy;
+  n++;
+  double inv_n = 1.0 / n;
 
-  for (int t = 0; t < NUM_TEAMS; t++) {
-    for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      SquareVal(val.robots[t][i].vision);
-      val.robots[t][i].state.x *= val.robots[t][i].state.x;
-      val.robots[t][i].state.y *= val.robots[t][i].state.y;
-      val.robots[t][i].state.theta *= val.robots[t][i].state.theta;
-      val.robots[t][i].state.vx *= val.robots[t][i].state.vx;
-      val.robots[t][i].state.vy *= val.robots[t][i].state.vy;
-      val.robots[t][i].state.vtheta *= val.robots[t][i].state.vtheta;
-      val.robots[t][i].state.stuck *= val.robots[t][i].state.stuck;
-    }
+  for (int k = 0; k < STATS_FIELDS; k++) {
+    double delta = s.v[k] - v_mean[k];
+    v_mean[k] += delta * inv_n;
+    v_m2[k] += delta * (s.v[k] - v_mean[k]);
   }
+
+  for (int k = 0; k < STATS_FIELDS; k++)
+    a_mean[k] += (s.a[k] - a_mean[k]) * inv_n;
+
+  for (int k = 0; k < STATS_OBJECTS; k++)
+    miss_mean[k] += (s.miss[k] - miss_mean[k]) * inv_n;
 }
 
-void FrameStats::CalculateVariance(net_vframe &res, net_vframe &valsq, net_vframe &avg)
+// Removes a sample previously added, inverting the Welford update.
+void FrameStats::Remove(sample &s)
 {
-  net_vframe sqavg = avg;
-  SquareVal(sqavg);
-  
-  res.ball.vision.conf = valsq.ball.vision.conf - sqavg.ball.vision.conf;
-  res.ball.vision.angle = valsq.ball.vision.angle - sqavg.ball.vision.angle;
-  res.ball.vision.pos = valsq.ball.vision.pos - sqavg.ball.vision.pos;
-
-  res.ball.state.x = valsq.ball.state.x - sqavg.ball.state.x;
-  res.ball.state.y = valsq.ball.state.y - sqavg.ball.state.y;
-  res.ball.state.vx = valsq.ball.state.vx - sqavg.ball.state.vx;
-  res.ball.state.vy = valsq.ball.state.vy - sqavg.ball.state.vy;
+  n--;
+
+  if (n == 0) {
+    memset(v_mean, 0, sizeof(v_mean));
+    memset(v_m2, 0, sizeof(v_m2));
+    memset(a_mean, 0, sizeof(a_mean));
+    memset(miss_mean, 0, sizeof(miss_mean));
+    return;
+  }
 
-  for (int t = 0; t < NUM_TEAMS; t++) {
-    for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      res.robots[t][i].vision.conf = valsq.robots[t][i].vision.conf - 
-	sqavg.robots[t][i].vision.conf;
-      res.robots[t][i].vision.angle = valsq.robots[t][i].vision.angle 
-	- sqavg.robots[t][i].vision.angle;
-      res.robots[t][i].vision.pos = valsq.robots[t][i].vision.pos 
-	- sqavg.robots[t][i].vision.pos;
-      
-      res.robots[t][i].state.x = valsq.robots[t][i].state.x 
-	- sqavg.robots[t][i].state.x;
-      res.robots[t][i].state.y = valsq.robots[t][i].state.y 
-	- sqavg.robots[t][i].state.y;
-      res.robots[t][i].state.theta = valsq.robots[t][i].state.theta 
-	- sqavg.robots[t][i].state.theta;
-      res.robots[t][i].state.vx = valsq.robots[t][i].state.vx 
-	- sqavg.robots[t][i].state.vx;
-      res.robots[t][i].state.vy = valsq.robots[t][i].state.vy 
-	- sqavg.robots[t][i].state.vy;
-      res.robots[t][i].state.vtheta = valsq.robots[t][i].state.vtheta 
-	- sqavg.robots[t][i].state.vtheta;
-      res.robots[t][i].state.stuck = valsq.robots[t][i].state.stuck 
-	- sqavg.robots[t][i].state.stuck;
-    }
+  double inv_n = 1.0 / n;
+
+  for (int k = 0; k < STATS_FIELDS; k++) {
+    double delta = s.v[k] - v_mean[k];
+    v_mean[k] -= delta * inv_n;
+    v_m2[k] -= delta * (s.v[k] - v_mean[k]);
   }
+
+  // Rounding can leave a tiny negative sum for constant fields.
+  for (int k = 0; k < STATS_FIELDS; k++)
+    if (v_m2[k] < 0.0) v_m2[k] = 0.0;
+
+  for (int k = 0; k < STATS_FIELDS; k++)
+    a_mean[k] -= (s.a[k] - a_mean[k]) * inv_n;
+
+  for (int k = 0; k < STATS_OBJECTS; k++)
+    miss_mean[k] -= (s.miss[k] - miss_mean[k]) * inv_n;
 }
 
 void FrameStats::CalculateMaxValues(net_vframe &val, net_vframe &add)
@@ -266,15 +223,13 @@ void FrameStats::CalculateMaxValues(net_vframe &val, net_vframe &add)
 }
 
 //Calculates Accelation and returns it for frame acc in state.vx and state.vy for use of old code
-void FrameStats::CalculateAcceleration()
+void FrameStats::CalculateAcceleration(net_vframe &curr)
 {
-  net_vframe prev;
-  net_vframe curr;
   double time;
 
-  if (vframes.size() > 1) {
-    prev = vframes[vframes.size()-2];
-    curr = vframes[vframes.size()-1];
+  if (n > 0) {
+    net_vframe &prev = at(n - 1).frame;
+
     time = curr.timestamp-prev.timestamp;
     acc.timestamp = curr.timestamp;
     acc.ball.vision = curr.ball.vision;
@@ -303,7 +258,7 @@ void FrameStats::CalculateAcceleration()
     acc.ball.state.vx=0;
     acc.ball.state.vy=0;
     for (int t=0; t<NUM_TEAMS; t++) {
-      for (int i=0; i<NUM_TEAMS; i++) {
+      for (int i=0; i<MAX_TEAM_ROBOTS; i++) {
 	acc.robots[t][i].state.vx=0;
 	acc.robots[t][i].state.vy=0;
       }
@@ -315,28 +270,29 @@ void FrameStats::CalculateAcceleration()
 bool FrameStats::Update(net_vframe &latest)
 {
   // check to make sure latest frame is new
-  if (!vframes.empty() && (latest.timestamp <= vframes[vframes.size() - 1].timestamp))
+  if (n > 0 && (latest.timestamp <= at(n - 1).frame.timestamp))
     return (true);
 
-  double n = (double) vframes.size();
-  net_vframe sqframe = latest;
-  SquareVal(sqframe);
-
-  // add it to the list 
-  vframes.push_back(latest);
-  sqframes.push_back(sqframe);
+  // make room if the window holds more frames than the ring
+  if (n == STATS_MAX_FRAMES) {
+    Remove(at(0));
+    start = (start + 1) % STATS_MAX_FRAMES;
+  }
 
   //Get Acceleration
-  CalculateAcceleration();
+  CalculateAcceleration(latest);
+
+  // add it to the ring
+  sample &s = at(n);
+
+  s.frame = latest;
+  s.acc = acc;
+  Pack(s.frame, s.v);
+  Pack(s.acc, s.a);
+  CountMissing(latest, s.miss);
 
-  // add that to its list
-  aframes.push_back(acc);
-  
   // update our averages
-  AddVal(mean, latest, n);
-  AddVal(sqmean, sqframe, n);
-  AddVal(avgacc, acc, n);
-  CountMissing(missing, latest, n);
+  Add(s);
 
   // work out how many to pop off
   double tcutoff = latest.timestamp - window;
@@ -347,82 +303,53 @@ bool FrameStats::Update(net_vframe &latest)
   CalculateMaxValues(maxacc, acc);
   if (maxframe.timestamp < tcutoff) {
     memset(&maxframe, 0, sizeof(maxframe));
-    for (uint i = 0; i < vframes.size(); i++) 
-      CalculateMaxValues(maxframe, vframes[i]);
+    for (int i = 0; i < n; i++) 
+      CalculateMaxValues(maxframe, at(i).frame);
   }
 
   if (maxacc.timestamp < tcutoff) {
     memset(&maxacc, 0, sizeof(maxacc));
-    for (uint i = 0; i < aframes.size(); i++) 
-      CalculateMaxValues(maxacc, aframes[i]);
+    for (int i = 0; i < n; i++) 
+      CalculateMaxValues(maxacc, at(i).acc);
   }
 
-  // now remove whatever is old from the list
+  // now remove whatever is old from the ring
   // and correct values accordingly
-  while (!vframes.empty() && (vframes[0].timestamp < tcutoff)) {
-    n = (double) vframes.size();
-    SubVal(mean, vframes[0], n);
-    UnCountMissing(missing, vframes[0], n);
-    vframes.pop_front();
-
-    n = (double) aframes.size();
-    SubVal(avgacc, aframes[0], n);
-    aframes.pop_front();
-    
-    n = (double) sqframes.size();
-    SubVal(sqmean, sqframes[0], n);
-    sqframes.pop_front();
+  while (n > 0 && (at(0).frame.timestamp < tcutoff)) {
+    Remove(at(0));
+    start = (start + 1) % STATS_MAX_FRAMES;
   }
 
-  // update the variance calculation
-  CalculateVariance(variances, sqmean, mean);
-  return true;
-}
+  // scatter the running statistics back into frames
+  double var[STATS_FIELDS];
 
-void FrameStats::CountMissing(net_vframe &miss, net_vframe &latest, double n)
-{
-  // count ball missing values
-  if ((latest.timestamp != latest.ball.vision.timestamp)
-      ||(latest.ball.vision.conf < DVAR(STATS_VISION_CONF))) {
-    missing.ball.vision.conf = (n * missing.ball.vision.conf + 1.0) / (n + 1.0);
-  } else {
-    missing.ball.vision.conf = (n * missing.ball.vision.conf) / (n + 1.0);
-  }
+  for (int k = 0; k < STATS_FIELDS; k++)
+    var[k] = (n > 0 ? v_m2[k] / n : 0.0);
 
-  for (int t = 0; t < NUM_TEAMS; t++) {
-    for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      if ((latest.timestamp != latest.robots[t][i].vision.timestamp)
-	  ||(latest.robots[t][i].vision.conf < DVAR(STATS_VISION_CONF))) {
-	missing.robots[t][i].vision.conf = 
-	  (n * missing.robots[t][i].vision.conf + 1.0) / (n + 1.0);
-      } else {
-	missing.robots[t][i].vision.conf = 
-	  (n * missing.robots[t][i].vision.conf) / (n + 1.0);
-      }
-    }
-  }
+  Unpack(v_mean, mean);
+  Unpack(var, variances);
+  Unpack(a_mean, avgacc);
+
+  missing.ball.vision.conf = miss_mean[0];
+  for (int t = 0; t < NUM_TEAMS; t++)
+    for (int i = 0; i < MAX_TEAM_ROBOTS; i++)
+      missing.robots[t][i].vision.conf = miss_mean[1 + t * MAX_TEAM_ROBOTS + i];
+
+  return true;
 }
 
-void FrameStats::UnCountMissing(net_vframe &miss, net_vframe &latest, double n)
+// flags each object that is unseen or below confidence in the latest frame
+void FrameStats::CountMissing(net_vframe &latest, float *miss)
 {
-  // count ball missing values
-  if ((latest.timestamp != latest.ball.vision.timestamp)
-      ||(latest.ball.vision.conf < DVAR(STATS_VISION_CONF))) {
-    missing.ball.vision.conf = (n * missing.ball.vision.conf - 1.0) / (n - 1.0);
-  } else {
-    missing.ball.vision.conf = (n * missing.ball.vision.conf) / (n - 1.0);
-  }
+  double conf = DVAR(STATS_VISION_CONF);
+
+  *miss++ = ((latest.timestamp != latest.ball.vision.timestamp)
+	     || (latest.ball.vision.conf < conf)) ? 1.0 : 0.0;
 
   for (int t = 0; t < NUM_TEAMS; t++) {
     for (int i = 0; i < MAX_TEAM_ROBOTS; i++) {
-      if ((latest.timestamp != latest.robots[t][i].vision.timestamp)
-	  ||(latest.robots[t][i].vision.conf < DVAR(STATS_VISION_CONF))) {
-	missing.robots[t][i].vision.conf = 
-	  (n * missing.robots[t][i].vision.conf - 1.0) / (n - 1.0);
-      } else {
-	missing.robots[t][i].vision.conf = 
-	  (n * missing.robots[t][i].vision.conf) / (n - 1.0);
-      }
+      *miss++ = ((latest.timestamp != latest.robots[t][i].vision.timestamp)
+		 || (latest.robots[t][i].vision.conf < conf)) ? 1.0 : 0.0;
     }
   }
 }
@@ -430,7 +357,7 @@ void FrameStats::UnCountMissing(net_vframe &miss, net_vframe &latest, double n)
 void FrameStats::Print(FILE *f)
 {
   if (verbose) {
-    fprintf(f, "Frame stats is based on %i records\n", vframes.size());
+    fprintf(f, "Frame stats is based on %i records\n", n);
     fprintf(f, "Ball: raw: c %1.4f [%1.6f]\n",
 	    mean.ball.vision.conf, variances.ball.vision.conf);
     fprintf(f, "\t: pos (%1.4f, %1.4f) [%1.4f, %1.4f]\n", 
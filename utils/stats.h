@@ -26,50 +26,66 @@
 #define __STATS_H__
 
 #include "reality/net_vision.h"
-#include <deque>
 #include <stdio.h>
 
+// The numeric fields statistics are kept on, packed into a flat array
+// of floats: the ball's vision conf, angle, pos and state x, y, vx, vy,
+// then for each robot its vision conf, angle, pos and state x, y,
+// theta, vx, vy, vtheta, stuck.
+#define STATS_BALL_FIELDS   8
+#define STATS_ROBOT_FIELDS 11
+#define STATS_OBJECTS      (1 + NUM_TEAMS * MAX_TEAM_ROBOTS)
+#define STATS_FIELDS \
+  (STATS_BALL_FIELDS + NUM_TEAMS * MAX_TEAM_ROBOTS * STATS_ROBOT_FIELDS)
+
+// Frames held in the window.  Older frames are dropped when it fills,
+// which at 60Hz is over four seconds.
+#define STATS_MAX_FRAMES 256
+
 class FrameStats {
 private:
-  deque<net_vframe> vframes, sqframes, aframes;
+  struct sample {
+    net_vframe frame, acc;
+    float v[STATS_FIELDS];
+    float a[STATS_FIELDS];
+    float miss[STATS_OBJECTS];
+  };
+
+  // Ring of the frames in the window, oldest at start.
+  sample *samples;
+  int start, n;
+
   double window;
   bool verbose;
-  
-  net_vframe mean, sqmean, variances, acc, avgacc;
-  net_vframe maxframe, maxacc;
 
-  net_vframe missing;
-  
-
-  inline void AddVal(double &val, double add, double n);
-  inline void SubVal(double &val, double sub, double n);
+  // Running means and sums of squared deviations (Welford) over the
+  // window, in the packed layout.
+  double v_mean[STATS_FIELDS], v_m2[STATS_FIELDS];
+  double a_mean[STATS_FIELDS];
+  double miss_mean[STATS_OBJECTS];
 
-  inline void AddVal(float &val, float add, double _n);
-  inline void SubVal(float &val, float sub, double _n);
+  net_vframe mean, variances, acc, avgacc;
+  net_vframe maxframe, maxacc;
 
-  inline void AddVal(vector2f &val, vector2f add, double _n);
-  inline void SubVal(vector2f &val, vector2f sub, double _n);
+  net_vframe missing;
 
-  inline void AddVal(vraw &val, vraw add, double n);
-  inline void SubVal(vraw &val, vraw sub, double n);
+  sample &at(int i) { return samples[(start + i) % STATS_MAX_FRAMES]; }
 
-  inline void SquareVal(vraw &val);
-  void SquareVal(net_vframe &val);
+  static void Pack(net_vframe &f, float *v);
+  static void Unpack(double *v, net_vframe &f);
 
-  void AddVal(net_vframe  &val, net_vframe add, double n);
-  void SubVal(net_vframe &val, net_vframe sub, double n);
+  void Add(sample &s);
+  void Remove(sample &s);
 
-  void CalculateVariance(net_vframe &res, net_vframe &sq, net_vframe &avg);
   void CalculateMaxValues(net_vframe &val, net_vframe &add);
-  void CalculateAcceleration();
+  void CalculateAcceleration(net_vframe &curr);
 
-  void CountMissing(net_vframe &miss, net_vframe &latest, double n);
-  void UnCountMissing(net_vframe &miss, net_vframe &latest, double n);
+  void CountMissing(net_vframe &latest, float *miss);
 
 public:
 
   FrameStats(double _window = 2.0, bool _verbose = false);
-  ~FrameStats(void) {}
+  ~FrameStats(void) { delete[] samples; }
 
   void SetVerbose(bool _verbose) {
     verbose = _verbose;
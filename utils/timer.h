@@ -32,6 +32,13 @@ public:
     tv1 = tv2;
     return(t);
   }
+
+  // wall clock time in seconds
+  static double now(){
+    timeval tv;
+    gettimeofday(&tv,NULL);
+    return(tv.tv_sec + tv.tv_usec / 1.0E6);
+  }
 };
 
 #endif